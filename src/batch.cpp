@@ -0,0 +1,311 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "batch.h"
+
+#include "catalog.h"
+#include "catalog_po.h"
+#include "cat_update.h"
+#include "errors.h"
+#include "json.h"
+#include "pretranslate.h"
+#include "str_helpers.h"
+
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/stopwatch.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+
+namespace
+{
+
+const char *CompilationStatusName(Catalog::CompilationStatus s)
+{
+    switch (s)
+    {
+        case Catalog::CompilationStatus::NotDone:
+            return "not_done";
+        case Catalog::CompilationStatus::Success:
+            return "success";
+        case Catalog::CompilationStatus::Error:
+            return "error";
+    }
+    return "error"; // silence VC++ warning
+}
+
+
+const char *LogLevelName(wxLogLevel level)
+{
+    switch (level)
+    {
+        case wxLOG_FatalError:
+        case wxLOG_Error:
+            return "error";
+        case wxLOG_Warning:
+            return "warning";
+        default:
+            return "info";
+    }
+}
+
+
+/**
+    Collects messages logged by a worker thread while it processes a file,
+    so that they are reported together with the file's results instead of
+    being interleaved with other threads' output.
+ */
+class FileLog : public wxLog
+{
+public:
+    /// Moves collected messages, if any, into the file's record
+    void MoveTo(json& record)
+    {
+        if (!m_messages.empty())
+            record["log"] = std::move(m_messages);
+        m_messages = json::array();
+    }
+
+protected:
+    void DoLogRecord(wxLogLevel level, const wxString& msg, const wxLogRecordInfo& /*info*/) override
+    {
+        if (level > wxLOG_Info)
+            return;  // debug and trace output isn't part of results
+        m_messages.push_back({{"level", LogLevelName(level)}, {"message", str::to_utf8(msg)}});
+    }
+
+private:
+    json m_messages = json::array();
+};
+
+
+class BatchProcessor
+{
+public:
+    BatchProcessor(const std::vector<wxString>& files, const BatchOptions& options)
+        : m_files(files), m_options(options), m_next(0),
+          m_failed(0), m_withErrors(0), m_totalErrors(0), m_totalPretranslated(0)
+    {}
+
+    int Run()
+    {
+        wxStopWatch sw;
+
+        unsigned jobs = m_options.jobs;
+        if (jobs == 0)
+            jobs = std::max(std::thread::hardware_concurrency(), 1u);
+        jobs = std::min(jobs, (unsigned)m_files.size());
+
+        boost::thread_group threads;
+        for (unsigned i = 0; i < jobs; ++i)
+            threads.create_thread([this]{ thread_worker(); });
+        threads.join_all();
+
+        json summary;
+        summary["files"] = m_files.size();
+        summary["failed"] = m_failed.load();
+        summary["with_errors"] = m_withErrors.load();
+        summary["errors"] = m_totalErrors.load();
+        if (m_options.pretranslate)
+            summary["pretranslated"] = m_totalPretranslated.load();
+        summary["time_ms"] = sw.Time();
+        Print(json{{"summary", summary}});
+
+        if (m_failed)
+            return 1;
+        if (m_options.validate && m_withErrors)
+            return 2;
+        return 0;
+    }
+
+private:
+    void thread_worker()
+    {
+        FileLog log;
+        wxLog::SetThreadActiveTarget(&log);
+
+        for (;;)
+        {
+            size_t index = m_next.fetch_add(1);
+            if (index >= m_files.size())
+                break;
+
+            auto r = ProcessFile(m_files[index]);
+            log.MoveTo(r);
+            Print(r);
+        }
+
+        wxLog::SetThreadActiveTarget(nullptr);
+    }
+
+    json ProcessFile(const wxString& filename)
+    {
+        wxStopWatch sw;
+
+        json r;
+        r["file"] = str::to_utf8(filename);
+
+        try
+        {
+            auto cat = Catalog::Create(filename);
+            bool modified = false;
+
+            Catalog::ValidationResults validation;
+            bool validated = false;
+            bool failed = false;
+
+            if (m_options.fixDuplicates)
+            {
+                auto po = std::dynamic_pointer_cast<POCatalog>(cat);
+                if (po && po->HasDuplicateItems())
+                {
+                    if (!po->FixDuplicateItems())
+                        BOOST_THROW_EXCEPTION(Exception(_("Fixing duplicate entries failed.")));
+                    modified = true;
+                    r["fixed_duplicates"] = true;
+                }
+            }
+
+            if (m_options.update)
+            {
+                auto merged = PerformUpdateFromSourcesSimple(cat);
+                if (!merged)
+                    BOOST_THROW_EXCEPTION(Exception(_("Updating from sources failed.")));
+                cat = merged.updated_catalog;
+                modified = true;
+                r["update_warnings"] = merged.errors.items.size();
+            }
+
+            if (m_options.pretranslate && cat->HasCapability(Catalog::Cap::Translations))
+            {
+                PreTranslateOptions pretranslateOptions;
+                auto& settings = m_options.pretranslateSettings;
+                if (settings.onlyExact)
+                    pretranslateOptions.flags |= PreTranslate_OnlyExact;
+                if (settings.exactNotFuzzy)
+                    pretranslateOptions.flags |= PreTranslate_ExactNotFuzzy;
+
+                auto stats = pretranslate::PreTranslateCatalog(cat, cat->items(), pretranslateOptions,
+                                                               std::make_shared<dispatch::cancellation_token>());
+                r["pretranslated"] = stats->matched.load();
+                r["pretranslated_exact"] = stats->exact.load();
+                r["pretranslate_qps"] = stats->queries_per_second();
+                m_totalPretranslated += stats->matched;
+                if (stats->matched)
+                    modified = true;
+            }
+
+            if (modified)
+            {
+                Catalog::CompilationStatus mo_status;
+                if (!cat->Save(filename, /*save_mo=*/false, validation, mo_status))
+                    BOOST_THROW_EXCEPTION(Exception(wxString::Format(_(L"Couldn’t save file %s."), filename)));
+                validated = true;
+                r["saved"] = true;
+            }
+
+            if (m_options.compile)
+            {
+                auto po = std::dynamic_pointer_cast<POCatalog>(cat);
+                if (po && po->GetFileType() == Catalog::Type::PO)
+                {
+                    auto mo_file = wxFileName::StripExtension(filename) + ".mo";
+                    Catalog::CompilationStatus mo_status;
+                    po->CompileToMO(mo_file, validation, mo_status);
+                    validated = true;
+                    r["mo"] = CompilationStatusName(mo_status);
+                    if (mo_status == Catalog::CompilationStatus::Error)
+                    {
+                        failed = true;
+                        r["message"] = str::to_utf8(_("The file cannot be compiled into the MO format and used."));
+                    }
+                }
+            }
+
+            if (m_options.validate)
+            {
+                if (!validated)
+                    validation = cat->Validate();
+                r["errors"] = validation.errors;
+                r["warnings"] = validation.warnings;
+                if (validation.errors)
+                {
+                    m_withErrors++;
+                    m_totalErrors += validation.errors;
+                }
+            }
+
+            int all, fuzzy, untranslated, unfinished;
+            cat->GetStatistics(&all, &fuzzy, nullptr, &untranslated, &unfinished);
+            r["strings"] = all;
+            r["translated"] = all - untranslated;
+            r["fuzzy"] = fuzzy;
+            r["unfinished"] = unfinished;
+
+            if (failed)
+                m_failed++;
+            r["status"] = failed ? "failed" : "ok";
+        }
+        catch (...)
+        {
+            m_failed++;
+            r["status"] = "failed";
+            r["message"] = str::to_utf8(DescribeCurrentException());
+        }
+
+        r["time_ms"] = sw.Time();
+        return r;
+    }
+
+    void Print(const json& j)
+    {
+        std::lock_guard lock(m_outputMutex);
+        std::cout << j.dump() << std::endl;
+    }
+
+private:
+    const std::vector<wxString>& m_files;
+    BatchOptions m_options;
+
+    std::atomic<size_t> m_next;
+    std::atomic<int> m_failed, m_withErrors, m_totalErrors, m_totalPretranslated;
+    std::mutex m_outputMutex;
+};
+
+} // anonymous namespace
+
+
+int RunBatchProcessing(const std::vector<wxString>& files, const BatchOptions& options)
+{
+    BatchProcessor processor(files, options);
+    return processor.Run();
+}
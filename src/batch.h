@@ -0,0 +1,69 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_batch_h
+#define Poedit_batch_h
+
+#include "configuration.h"
+
+#include <wx/string.h>
+
+#include <vector>
+
+
+/// Operations to perform on files in headless batch mode.
+struct BatchOptions
+{
+    bool update = false;        ///< update from source code
+    bool pretranslate = false;  ///< pre-translate from TM
+    bool validate = false;      ///< check for errors
+    bool compile = false;       ///< compile MO files (PO only)
+    bool fixDuplicates = false; ///< merge duplicate entries (PO only)
+
+    /// Settings used by pre-translation, read from Config before processing starts
+    PretranslateSettings pretranslateSettings = {false, true};
+
+    /// Number of files processed concurrently; 0 to use number of CPUs
+    unsigned jobs = 0;
+};
+
+
+/**
+    Process @a files without any UI, e.g. in CI or from scripts.
+
+    The files are processed concurrently. Results are printed to stdout as
+    JSON, one object per line and file, followed by a summary object.
+    Messages logged while processing a file are included in its object
+    under the "log" key instead of being printed.
+
+    Must be called from a background thread: some operations (running
+    gettext tools) need the main thread's event loop to be running.
+
+    Returns process exit code: 0 on success, 1 if some file couldn't be
+    processed and 2 if validation found errors.
+ */
+int RunBatchProcessing(const std::vector<wxString>& files, const BatchOptions& options);
+
+#endif // Poedit_batch_h
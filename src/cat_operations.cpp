@@ -29,8 +29,10 @@
 #include "concurrency.h"
 #include "progress.h"
 
-#include <map>
-#include <set>
+#include <wx/hashmap.h>
+
+#include <algorithm>
+#include <unordered_map>
 
 
 namespace
@@ -41,25 +43,122 @@ inline MergeStats::Key make_key_full(const CatalogItemPtr& i)
     return {i->GetRawString(), i->GetRawPluralString(), i->GetContext(), i->GetRawSymbolicId()};
 }
 
-template<auto MakeKey = make_key_full, typename TFunc>
-inline void build_item_keys(CatalogPtr cat, TFunc&& f)
+/// Computes 64-bit hash of the key (FNV-1a, with final avalanche mixing)
+uint64_t hash_key(const MergeStats::Key& key)
 {
-    for (auto& i: cat->items())
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (auto s: {&key.str, &key.str_plural, &key.context, &key.sym_id})
     {
-        f(MakeKey(i), i);
+        const wchar_t *data = s->wc_str();
+        const size_t length = s->length();
+        for (size_t i = 0; i < length; i++)
+        {
+            h ^= (uint64_t)data[i];
+            h *= 0x100000001b3ULL;
+        }
+        // separate the fields, so that e.g. ("ab", "") differs from ("a", "b"):
+        h ^= (uint64_t)length + 0x9e3779b97f4a7c15ULL;
+        h *= 0x100000001b3ULL;
     }
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
 }
 
-template<auto MakeKey = make_key_full, typename T>
-inline void build_item_map(T& map, CatalogPtr cat)
+struct MergeKeyHash
 {
-    build_item_keys<MakeKey>(cat, [&](auto&& key, CatalogItemPtr i){ map.emplace(key, i); });
-}
+    size_t operator()(const MergeStats::Key& key) const { return (size_t)hash_key(key); }
+};
+
 
-template<auto MakeKey = make_key_full, typename T>
-inline void build_item_set(T& map, CatalogPtr cat)
+/**
+    Set of a catalog's unique keys, stored in a flat open-addressing hash table.
+
+    Keys are compared by their 64-bit hashes first and only verified with
+    full comparison if hashes match, so collisions are handled correctly.
+ */
+class MergeKeySet
 {
-    build_item_keys<MakeKey>(cat, [&](auto&& key, CatalogItemPtr){ map.insert(key); });
+public:
+    void Build(CatalogPtr cat)
+    {
+        auto& items = cat->items();
+
+        m_keys.clear();
+        m_hashes.clear();
+        m_keys.reserve(items.size());
+        m_hashes.reserve(items.size());
+
+        size_t capacity = 16;
+        while (capacity < items.size() * 2)
+            capacity *= 2;
+        m_slots.assign(capacity, EMPTY);
+
+        for (auto& i: items)
+        {
+            auto key = make_key_full(i);
+            auto hash = hash_key(key);
+            auto slot = FindSlot(key, hash);
+            if (m_slots[slot] != EMPTY)
+                continue; // duplicate
+
+            m_slots[slot] = m_keys.size();
+            m_keys.push_back(std::move(key));
+            m_hashes.push_back(hash);
+        }
+    }
+
+    bool Contains(const MergeStats::Key& key, uint64_t hash) const
+    {
+        return m_slots[FindSlot(key, hash)] != EMPTY;
+    }
+
+    /// Appends keys from this set that aren't present in @a other to @a out, sorted.
+    void CollectMissingFrom(const MergeKeySet& other, std::vector<MergeStats::Key>& out) const
+    {
+        for (size_t i = 0; i < m_keys.size(); i++)
+        {
+            if (!other.Contains(m_keys[i], m_hashes[i]))
+                out.push_back(m_keys[i]);
+        }
+        // keep the order stable, as it's shown in the UI:
+        std::sort(out.begin(), out.end());
+    }
+
+private:
+    static constexpr size_t EMPTY = size_t(-1);
+
+    // Returns slot with the key or empty slot where it should be inserted
+    size_t FindSlot(const MergeStats::Key& key, uint64_t hash) const
+    {
+        const size_t mask = m_slots.size() - 1;
+        for (size_t pos = (size_t)hash & mask;; pos = (pos + 1) & mask)
+        {
+            const size_t index = m_slots[pos];
+            if (index == EMPTY)
+                return pos;
+            if (m_hashes[index] == hash && m_keys[index] == key)
+                return pos;
+        }
+    }
+
+    std::vector<MergeStats::Key> m_keys;
+    std::vector<uint64_t> m_hashes;
+    std::vector<size_t> m_slots;  // indexes into m_keys
+};
+
+inline bool has_translation(const CatalogItemPtr& item)
+{
+    for (auto& t: item->GetTranslations())
+    {
+        if (!t.empty())
+            return true;
+    }
+    return false;
 }
 
 } // anonymous namespace
@@ -72,35 +171,21 @@ void ComputeMergeStats(MergeStats& r, CatalogPtr po, CatalogPtr refcat)
     r.added.clear();
     r.removed.clear();
 
-    // First collect all strings from both sides, then diff the sets.
+    // First collect all strings from both sides, then diff them, probing
+    // the other side's hash table just once for each key.
     // Run the two sides in parallel for speed up on large files.
 
-    std::set<MergeStats::Key> strsThis, strsRef;
+    MergeKeySet strsThis, strsRef;
 
-    auto collect1 = dispatch::async([&]{ build_item_set(strsThis, po); });
-    auto collect2 = dispatch::async([&]{ build_item_set(strsRef, refcat); });
+    auto collect1 = dispatch::async([&]{ strsThis.Build(po); });
+    auto collect2 = dispatch::async([&]{ strsRef.Build(refcat); });
 
     collect1.get();
     collect2.get();
     progress.increment();
 
-    auto add1 = dispatch::async([&]
-    {
-        for (auto& i: strsThis)
-        {
-            if (strsRef.find(i) == strsRef.end())
-                r.removed.push_back(i);
-        }
-    });
-
-    auto add2 = dispatch::async([&]
-    {
-        for (auto& i: strsRef)
-        {
-            if (strsThis.find(i) == strsThis.end())
-                r.added.push_back(i);
-        }
-    });
+    auto add1 = dispatch::async([&]{ strsThis.CollectMissingFrom(strsRef, r.removed); });
+    auto add2 = dispatch::async([&]{ strsRef.CollectMissingFrom(strsThis, r.added); });
 
     add1.get();
     add2.get();
@@ -120,12 +205,139 @@ MergeResult MergeCatalogWithReferencePO(POCatalogPtr catalog, POCatalogPtr ref)
 }
 
 
+MergeResult MergeCatalogWithReferenceNative(CatalogPtr catalog, CatalogPtr ref, bool fuzzyMatching)
+{
+    if (!catalog || !ref || catalog->GetFileType() != ref->GetFileType())
+        return {};
+
+    switch (ref->GetFileType())
+    {
+        case Catalog::Type::XCLOC:
+            // XCLOC catalogs are bound to their bundle and can't be saved elsewhere
+            return {};
+        default:
+            break;
+    }
+
+    Progress progress(3);
+
+    fuzzyMatching = fuzzyMatching && ref->HasCapability(Catalog::Cap::FuzzyTranslations);
+
+    auto& oldItems = catalog->items();
+    auto& refItems = ref->items();
+
+    // Index existing items by their keys; for fuzzy matching, also by symbolic ID
+    // or, if there is none, by source text alone. Only the first occurrence of a
+    // key is used, duplicates would have the same translation anyway:
+    std::unordered_map<MergeStats::Key, size_t, MergeKeyHash> exactIndex;
+    std::unordered_map<wxString, size_t, wxStringHash, wxStringEqual> fuzzyIndexById, fuzzyIndexBySource;
+
+    // ...and build keys of reference items on this thread in the meantime:
+    std::vector<MergeStats::Key> refKeys;
+
+    auto indexing = dispatch::async([&]
+    {
+        exactIndex.reserve(oldItems.size());
+        for (size_t i = 0; i < oldItems.size(); i++)
+        {
+            auto& item = oldItems[i];
+            exactIndex.emplace(make_key_full(item), i);
+
+            if (fuzzyMatching && has_translation(item))
+            {
+                auto id = item->GetRawSymbolicId();
+                if (!id.empty())
+                    fuzzyIndexById.emplace(id, i);
+                else
+                    fuzzyIndexBySource.emplace(item->GetRawString(), i);
+            }
+        }
+    });
+
+    refKeys.reserve(refItems.size());
+    for (auto& item: refItems)
+        refKeys.push_back(make_key_full(item));
+
+    indexing.get();
+    progress.increment();
+
+    // Match items in parallel; this only reads from the catalogs, so it's safe:
+    static const size_t NO_MATCH = size_t(-1);
+    struct Match
+    {
+        size_t index = NO_MATCH;
+        bool fuzzy = false;
+    };
+    std::vector<Match> matches(refItems.size());
+
+    dispatch::parallel_for(refItems.size(), [&](size_t i)
+    {
+        auto& m = matches[i];
+
+        auto exact = exactIndex.find(refKeys[i]);
+        if (exact != exactIndex.end())
+        {
+            m.index = exact->second;
+            return;
+        }
+
+        if (!fuzzyMatching)
+            return;
+
+        auto& key = refKeys[i];
+        auto fuzzy = !key.sym_id.empty() ? fuzzyIndexById.find(key.sym_id) : fuzzyIndexBySource.find(key.str);
+        auto fuzzyEnd = !key.sym_id.empty() ? fuzzyIndexById.end() : fuzzyIndexBySource.end();
+        if (fuzzy != fuzzyEnd && oldItems[fuzzy->second]->HasPlural() == refItems[i]->HasPlural())
+        {
+            m.index = fuzzy->second;
+            m.fuzzy = true;
+        }
+    });
+    progress.increment();
+
+    // Transfer translations. Updating items modifies the underlying document, which
+    // isn't thread-safe for all formats, so this must be done serially:
+    const bool hasComments = ref->HasCapability(Catalog::Cap::UserComments);
+
+    for (size_t i = 0; i < refItems.size(); i++)
+    {
+        auto& m = matches[i];
+        if (m.index == NO_MATCH)
+            continue;
+
+        auto& oldItem = oldItems[m.index];
+        auto& refItem = refItems[i];
+
+        if (has_translation(oldItem))
+        {
+            refItem->SetTranslations(oldItem->GetTranslations());
+            refItem->SetFuzzy(oldItem->IsFuzzy() || m.fuzzy);
+        }
+        if (hasComments && oldItem->HasComment())
+            refItem->SetComment(oldItem->GetComment());
+    }
+
+    // The reference now represents the catalog:
+    ref->SetFileName(catalog->GetFileName());
+    if (ref->HasCapability(Catalog::Cap::LanguageSetting) && catalog->GetLanguage().IsValid())
+        ref->SetLanguage(catalog->GetLanguage());
+
+    progress.increment();
+
+    return {ref};
+}
+
+
 MergeResult MergeCatalogWithReferenceRaw(CatalogPtr catalog, CatalogPtr reference)
 {
     auto po_catalog = std::dynamic_pointer_cast<POCatalog>(catalog);
     auto po_ref = std::dynamic_pointer_cast<POCatalog>(reference);
 
-    return MergeCatalogWithReferencePO(po_catalog, po_ref);
+    if (po_catalog && po_ref)
+        return MergeCatalogWithReferencePO(po_catalog, po_ref);
+
+    // other formats don't have their own merging implementation:
+    return MergeCatalogWithReferenceNative(catalog, reference);
 }
 
 
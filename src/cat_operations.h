@@ -37,6 +37,7 @@ struct MergeStats
     {
         wxString str, str_plural, context, sym_id;
 
+        Key() {}
         Key(const wxString& sym_id_) : sym_id(sym_id_) {}
         Key(const wxString& str_, const wxString& str_plural_, const wxString& context_)
             : str(str_), str_plural(str_plural_), context(context_) {}
@@ -48,6 +49,11 @@ struct MergeStats
             return std::tie(str, str_plural, context, sym_id) < std::tie(other.str, other.str_plural, other.context, other.sym_id);
         }
 
+        bool operator==(const Key& other) const
+        {
+            return str == other.str && str_plural == other.str_plural && context == other.context && sym_id == other.sym_id;
+        }
+
         wxString to_string() const
         {
             wxString s = str;
@@ -101,4 +107,22 @@ extern void ComputeMergeStats(MergeStats& r, CatalogPtr catalog, CatalogPtr refe
  */
 extern MergeResult MergeCatalogWithReference(CatalogPtr catalog, CatalogPtr reference);
 
+
+/**
+    Format-neutral merge, used for file types that don't have their own.
+
+    Items are matched on their keys (symbolic ID, context and source text).
+    The @a reference catalog, which has the up-to-date structure, becomes the
+    updated catalog and translations are carried over into it from matching
+    items of @a catalog. Both catalogs must be of the same type.
+
+    If @a fuzzyMatching is enabled and the file type supports fuzzy translations,
+    items whose source text or context changed are matched too, on symbolic ID
+    or source text, and their translations are marked as fuzzy.
+
+    @warning The @a reference object cannot be used after being passed to this function!
+ */
+extern MergeResult MergeCatalogWithReferenceNative(CatalogPtr catalog, CatalogPtr reference,
+                                                   bool fuzzyMatching = true);
+
 #endif // Poedit_cat_operations_h
@@ -26,6 +26,7 @@
 #include "catalog.h"
 
 #include "catalog_po.h"
+#include "catalog_cache.h"
 #include "catalog_xliff.h"
 #include "catalog_json.h"
 #include "catalog_xcloc.h"
@@ -55,7 +56,12 @@
 #include <wx/memtext.h>
 #include <wx/filename.h>
 
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
+
 #include <algorithm>
+#include <limits>
+#include <mutex>
 #include <set>
 #include <regex>
 
@@ -542,16 +548,27 @@ CatalogItemPtr Catalog::FindItemByLine(int lineno)
 
 int Catalog::FindItemIndexByLine(int lineno)
 {
-    int last = -1;
+    if (m_lineIndexGeneration != m_itemsGeneration)
+        BuildLineIndex();
+
+    // first item that starts after lineno; the one before it contains the line:
+    auto i = std::upper_bound(m_lineIndex.begin(), m_lineIndex.end(), lineno);
+    return int(i - m_lineIndex.begin()) - 1;
+}
+
+void Catalog::BuildLineIndex()
+{
+    m_lineIndex.clear();
+    m_lineIndex.reserve(m_items.size());
 
+    int maxLine = std::numeric_limits<int>::min();
     for (auto& i: m_items)
     {
-        if (i->GetLineNumber() > lineno)
-            return last;
-        last++;
+        maxLine = std::max(maxLine, i->GetLineNumber());
+        m_lineIndex.push_back(maxLine);
     }
 
-    return last;
+    m_lineIndexGeneration = m_itemsGeneration;
 }
 
 
@@ -839,16 +856,19 @@ void CatalogItem::SetFlags(const wxString& flags)
 {
     static const wxString flag_fuzzy(wxS(", fuzzy"));
 
-    m_moreFlags = flags;
+    m_isDirty = true;
 
     if (flags.find(flag_fuzzy) != wxString::npos)
     {
         m_isFuzzy = true;
-        m_moreFlags.Replace(flag_fuzzy, wxString());
+        wxString moreFlags(flags);
+        moreFlags.Replace(flag_fuzzy, wxString());
+        m_moreFlags = StringPool::Wrap(moreFlags);
     }
     else
     {
         m_isFuzzy = false;
+        m_moreFlags = StringPool::Wrap(flags);
     }
 }
 
@@ -858,29 +878,30 @@ wxString CatalogItem::GetFlags() const
     if (m_isFuzzy)
     {
         static const wxString flag_fuzzy(wxS(", fuzzy"));
-        if (m_moreFlags.empty())
+        if (!m_moreFlags)
             return flag_fuzzy;
         else
-            return flag_fuzzy + m_moreFlags;
+            return flag_fuzzy + *m_moreFlags;
     }
     else
     {
-        return m_moreFlags;
+        return StringPool::Get(m_moreFlags);
     }
 }
 
 std::string CatalogItem::GetFormatFlag() const
 {
-    if (m_moreFlags.empty())
+    if (!m_moreFlags)
         return std::string();
 
-    auto pos = m_moreFlags.find(wxS("-format"));
+    auto& flags = *m_moreFlags;
+    auto pos = flags.find(wxS("-format"));
     if (pos == wxString::npos)
         return std::string();
-    auto space = m_moreFlags.find_last_of(" \t", pos);
+    auto space = flags.find_last_of(" \t", pos);
     auto format = (space == wxString::npos)
-                    ? m_moreFlags.substr(0, pos)
-                    : m_moreFlags.substr(space+1, pos-space-1);
+                    ? flags.substr(0, pos)
+                    : flags.substr(space+1, pos-space-1);
     if (format.starts_with("no-"))
         return std::string();
     return std::string(format.begin(), format.end());
@@ -892,22 +913,80 @@ void CatalogItem::SetFuzzy(bool fuzzy)
         return;
 
     if (!fuzzy && m_isFuzzy)
-        m_oldMsgid.clear();
+    {
+        EnsureDeferredDataLoaded();
+        m_oldMsgid.reset();
+    }
     m_isFuzzy = fuzzy;
+    m_isDirty = true;
 
     UpdateInternalRepresentation();
 }
 
 void CatalogItem::SetComment(const wxString& c)
 {
-    if (c == m_comment)
+    if (c == GetComment())
         return;
 
-    m_comment = c;
+    m_comment = StringPool::Wrap(c);
+    m_isDirty = true;
     UpdateInternalRepresentation();
 }
 
 
+void CatalogItem::AddExtractedComments(const wxString& com)
+{
+    EnsureDeferredDataLoaded();
+    wxArrayString comments(StringPool::Get(m_extractedComments));
+    comments.Add(com);
+    m_extractedComments = StringPool::Wrap(comments);
+    m_isDirty = true;
+}
+
+void CatalogItem::SetExtractedComments(const wxArrayString& comments)
+{
+    EnsureDeferredDataLoaded();
+    m_extractedComments = StringPool::Wrap(comments);
+    m_isDirty = true;
+}
+
+void CatalogItem::SetOldMsgid(const wxArrayString& data)
+{
+    EnsureDeferredDataLoaded();
+    m_oldMsgid = StringPool::Wrap(data);
+    m_isDirty = true;
+}
+
+void CatalogItem::DoLoadDeferredData()
+{
+    // Loading is rare and quick, a single lock for all items is sufficient:
+    static std::mutex s_mutex;
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    // another thread may have loaded the data in the meantime:
+    if (!m_hasDeferredData.load(std::memory_order_relaxed))
+        return;
+
+    LoadDeferredData();
+    m_hasDeferredData.store(false, std::memory_order_release);
+}
+
+void CatalogItem::InternData(StringPool& pool)
+{
+    // plural strings are unique and don't benefit from interning
+    if (m_context)
+        m_context = pool.Intern(*m_context);
+    if (m_comment)
+        m_comment = pool.Intern(*m_comment);
+    if (m_moreFlags)
+        m_moreFlags = pool.Intern(*m_moreFlags);
+    if (m_extractedComments)
+        m_extractedComments = pool.Intern(*m_extractedComments);
+    if (m_oldMsgid)
+        m_oldMsgid = pool.Intern(*m_oldMsgid);
+}
+
+
 wxString CatalogItem::GetTranslation(unsigned idx) const
 {
     if (idx >= GetNumberOfTranslations())
@@ -921,6 +1000,7 @@ void CatalogItem::SetTranslation(const wxString &t, unsigned idx)
     while (idx >= m_translations.GetCount())
         m_translations.Add(wxEmptyString);
     m_translations[idx] = t;
+    m_isDirty = true;
 
     ClearIssue();
 
@@ -940,6 +1020,7 @@ void CatalogItem::SetTranslation(const wxString &t, unsigned idx)
 void CatalogItem::SetTranslations(const wxArrayString &t)
 {
     m_translations = t;
+    m_isDirty = true;
 
     ClearIssue();
 
@@ -959,6 +1040,7 @@ void CatalogItem::SetTranslations(const wxArrayString &t)
 void CatalogItem::SetTranslationFromSource()
 {
     ClearIssue();
+    m_isDirty = true;
     m_isFuzzy = false;
     m_isPreTranslated = false;
     m_isTranslated = true;
@@ -975,9 +1057,9 @@ void CatalogItem::SetTranslationFromSource()
         ++iter;
         for ( ; iter != m_translations.end(); ++iter )
         {
-            if (*iter != m_plural)
+            if (*iter != GetRawPluralString())
             {
-                *iter = m_plural;
+                *iter = GetRawPluralString();
                 m_isModified = true;
             }
         }
@@ -1002,7 +1084,10 @@ void CatalogItem::ClearTranslation()
     m_isModified = modified;
 
     if (modified)
+    {
+        m_isDirty = true;
         UpdateInternalRepresentation();
+    }
 }
 
 unsigned CatalogItem::GetPluralFormsCount() const
@@ -1017,7 +1102,7 @@ unsigned CatalogItem::GetPluralFormsCount() const
 wxString CatalogItem::GetOldMsgid() const
 {
     wxString s;
-    for (auto line: m_oldMsgid)
+    for (auto line: GetOldMsgidRaw())
     {
         if (line.length() < 2)
             continue;
@@ -1035,6 +1120,20 @@ wxString CatalogItem::GetOldMsgid() const
 }
 
 
+std::string Catalog::SaveToBuffer()
+{
+    // write directly into the string, std::ostringstream would make another copy
+    namespace io = boost::iostreams;
+    std::string buffer;
+    {
+        io::stream<io::back_insert_device<std::string>> out(buffer);
+        if (!SaveToStream(out))
+            return std::string();
+    }
+    return buffer;
+}
+
+
 Catalog::ValidationResults Catalog::Validate(const wxString& /*fileWithSameContent*/)
 {
     ValidationResults res;
@@ -1152,9 +1251,21 @@ CatalogPtr Catalog::Create(const wxString& filename, int flags)
     wxFileName::SplitPath(filename, nullptr, nullptr, nullptr, &ext);
     ext.MakeLower();
 
+    const int creationFlags = flags;
+
     CatalogPtr cat;
     if (POCatalog::CanLoadFile(ext))
     {
+        // Reopening unchanged large file is much faster from the cache:
+        if (creationFlags == 0)
+        {
+            if (auto cached = CatalogCache::Load(filename))
+            {
+                cached->SetFileName(filename);
+                return cached;
+            }
+        }
+
         cat.reset(new POCatalog(filename, flags));
         flags = 0; // don't do the stuff below that is already handled by POCatalog's parser
     }
@@ -1191,6 +1302,12 @@ CatalogPtr Catalog::Create(const wxString& filename, int flags)
     cat->SetFileName(filename);
     cat->PostCreation();
 
+    if (creationFlags == 0)
+    {
+        if (auto pocat = std::dynamic_pointer_cast<POCatalog>(cat))
+            CatalogCache::Store(*pocat);
+    }
+
     return cat;
 }
 
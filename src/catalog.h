@@ -27,11 +27,13 @@
 #define Poedit_catalog_h
 
 #include "language.h"
+#include "string_pool.h"
 
 #include <wx/encconv.h>
 #include <wx/arrstr.h>
 #include <wx/textfile.h>
 
+#include <atomic>
 #include <initializer_list>
 #include <iostream>
 #include <map>
@@ -88,13 +90,14 @@ class CatalogItem
         /// Ctor. Initializes the object with source string and translation.
         CatalogItem()
                 : m_id(0),
+                  m_lineNum(0),
                   m_hasPlural(false),
                   m_hasContext(false),
                   m_isFuzzy(false),
                   m_isTranslated(false),
                   m_isModified(false),
                   m_isPreTranslated(false),
-                  m_lineNum(0)
+                  m_isDirty(true)
         {}
 
         CatalogItem(const CatalogItem&) = delete;
@@ -112,7 +115,7 @@ class CatalogItem
         // Implementation for use in derived classes:
         virtual wxString GetRawSymbolicId() const { return wxString(); }
         const wxString& GetRawString() const { return m_string; }
-        const wxString& GetRawPluralString() const { return m_plural; }
+        const wxString& GetRawPluralString() const { return StringPool::Get(m_plural); }
 
         /// Get item's symbolic ID if used by the file
         wxString GetSymbolicId() const { return m_sideloaded ? GetRawString() : GetRawSymbolicId(); }
@@ -132,7 +135,7 @@ class CatalogItem
 
         /// Returns context string (can only be called if HasContext() returns
         /// true and empty string is accepted value).
-        const wxString& GetContext() const { return m_context; }
+        const wxString& GetContext() const { return StringPool::Get(m_context); }
 
         /// How many translations (plural forms) do we have?
         unsigned GetNumberOfTranslations() const
@@ -154,13 +157,19 @@ class CatalogItem
         virtual wxArrayString GetReferences() const = 0;
 
         /// Returns comment added by the translator to this entry
-        const wxString& GetComment() const { return m_comment; }
+        const wxString& GetComment() const { return StringPool::Get(m_comment); }
 
         /// Returns array of all auto comments.
-        const wxArrayString& GetExtractedComments() const { return m_sideloaded ? m_sideloaded->extracted_comments : m_extractedComments; }
+        const wxArrayString& GetExtractedComments() const
+        {
+            if (m_sideloaded)
+                return m_sideloaded->extracted_comments;
+            EnsureDeferredDataLoaded();
+            return StringPool::Get(m_extractedComments);
+        }
 
         /// Convenience function: does this entry has a comment?
-        bool HasComment() const { return !m_comment.empty(); }
+        bool HasComment() const { return m_comment != nullptr; }
 
         /// Convenience function: does this entry has auto comments?
         bool HasExtractedComments() const { return !GetExtractedComments().empty(); }
@@ -188,12 +197,19 @@ class CatalogItem
         bool IsModified() const { return m_isModified; }
         /// Gets value of pre-translated translation flag.
         bool IsPreTranslated() const { return m_isPreTranslated; }
+        /** Was the item changed since it was loaded or last saved?
+            Unlike IsModified(), this covers any change to saved data and is
+            reset by saving.
+         */
+        bool IsDirty() const { return m_isDirty; }
+        /// Marks the item as being in sync with the file.
+        void ClearDirty() { m_isDirty = false; }
         /// Get line number of this entry.
         int GetLineNumber() const { return m_lineNum; }
 
-        const wxArrayString& GetOldMsgidRaw() const { return m_oldMsgid; }
+        const wxArrayString& GetOldMsgidRaw() const { EnsureDeferredDataLoaded(); return StringPool::Get(m_oldMsgid); }
         wxString GetOldMsgid() const;
-        bool HasOldMsgid() const { return !m_oldMsgid.empty(); }
+        bool HasOldMsgid() const { EnsureDeferredDataLoaded(); return m_oldMsgid != nullptr; }
 
 
         // -------------------------------------------------------------------
@@ -272,29 +288,30 @@ class CatalogItem
         void SetString(const wxString& s)
         {
             m_string = s;
+            m_isDirty = true;
             ClearIssue();
         }
 
         void SetPluralString(const wxString& p)
         {
-            m_plural = p;
+            m_plural = StringPool::Wrap(p);
             m_hasPlural = true;
+            m_isDirty = true;
         }
 
         void SetContext(const wxString& context)
         {
             m_hasContext = true;
-            m_context = context;
+            m_context = StringPool::Wrap(context);
+            m_isDirty = true;
         }
 
         void SetLineNumber(int line) { m_lineNum = line; }
 
-        void AddExtractedComments(const wxString& com)
-        {
-            m_extractedComments.Add(com);
-        }
+        void AddExtractedComments(const wxString& com);
+        void SetExtractedComments(const wxArrayString& comments);
 
-        void SetOldMsgid(const wxArrayString& data) { m_oldMsgid = data; }
+        void SetOldMsgid(const wxArrayString& data);
 
         /** Sets gettext flags directly in string format. It may be
             either empty string or ", fuzzy", ", c-format",
@@ -303,26 +320,53 @@ class CatalogItem
          */
         void SetFlags(const wxString& flags);
 
-    protected:
-        int m_id;
+        /// Replaces secondary data with instances shared through @a pool.
+        virtual void InternData(StringPool& pool);
+
+        /**
+            Rarely used fields (extracted comments, old msgid and references
+            in derived classes) may be loaded lazily, on first access, so that
+            loading doesn't spend time and memory on them.
+
+            Derived classes that defer loading call SetHasDeferredData() and
+            implement LoadDeferredData(), which is called once, thread-safely,
+            before the fields are first read or modified. It must assign the
+            fields directly, not through setters.
+         */
+        virtual void LoadDeferredData() {}
+        void SetHasDeferredData() { m_hasDeferredData.store(true, std::memory_order_release); }
+        bool HasDeferredData() const { return m_hasDeferredData.load(std::memory_order_acquire); }
+        void EnsureDeferredDataLoaded() const
+        {
+            if (HasDeferredData())
+                const_cast<CatalogItem*>(this)->DoLoadDeferredData();
+        }
 
-        wxString m_string, m_plural;
-        bool m_hasPlural;
+    private:
+        void DoLoadDeferredData();
 
-        bool m_hasContext;
-        wxString m_context;
+    protected:
+        int m_id;
+        int m_lineNum;
 
+        wxString m_string;
         wxArrayString m_translations;
 
-        wxArrayString m_extractedComments;
-        wxArrayString m_oldMsgid;
-        bool m_isFuzzy, m_isTranslated, m_isModified, m_isPreTranslated;
-        wxString m_moreFlags;
-        wxString m_comment;
-        int m_lineNum;
+        // Secondary data, repeated across many items, are stored in shared
+        // immutable form (see StringPool); empty values take no memory:
+        InternedString m_plural, m_context, m_comment, m_moreFlags;
+        InternedStringArray m_extractedComments, m_oldMsgid;
+
+        bool m_hasPlural : 1;
+        bool m_hasContext : 1;
+        bool m_isFuzzy : 1, m_isTranslated : 1, m_isModified : 1, m_isPreTranslated : 1;
+        bool m_isDirty : 1;
 
         std::shared_ptr<Issue> m_issue;
         std::shared_ptr<SideloadedItemData> m_sideloaded;
+
+    private:
+        std::atomic<bool> m_hasDeferredData{false};
 };
 
 
@@ -483,13 +527,21 @@ class Catalog
                           ValidationResults& validation_results,
                           CompilationStatus& mo_compilation_status) = 0;
 
+        /**
+            "Saves" the file into @a out, with content identical to what
+            Save() would save into a file.
+
+            Returns false in case of failure.
+         */
+        virtual bool SaveToStream(std::ostream& out) = 0;
+
         /**
             "Saves" the PO file into a memory buffer with content identical
             to what Save() would save into a file.
             
             Returns empty string in case of failure.
          */
-        virtual std::string SaveToBuffer() = 0;
+        virtual std::string SaveToBuffer();
 
         /// File mask for opening/saving this catalog's file type
         wxString GetFileMask() const { return GetTypesFileMask({m_fileType}); }
@@ -591,7 +643,11 @@ class Catalog
         /// Finds item by line number
         CatalogItemPtr FindItemByLine(int lineno);
 
-        /// Finds catalog index by line number
+        /** Finds catalog index by line number.
+
+            Returns index of the item that contains line @a lineno, i.e. the
+            last item starting at or before it, or -1 if there's no such item.
+         */
         int FindItemIndexByLine(int lineno);
 
 
@@ -627,6 +683,22 @@ class Catalog
         /// Perform post-creation processing to e.g. fixup issues, detect missing language etc.
         virtual void PostCreation();
 
+        /// Appends @a item to m_items.
+        void AppendItem(CatalogItemPtr item) { m_items.push_back(std::move(item)); MarkItemsChanged(); }
+
+        /**
+            Invalidates data derived from items, e.g. the index used by
+            FindItemIndexByLine().
+
+            Must be called after every modification of m_items other than
+            AppendItem() (assignment, removal, reordering) and whenever items'
+            line numbers change (e.g. after saving).
+         */
+        void MarkItemsChanged() { ++m_itemsGeneration; }
+
+    private:
+        void BuildLineIndex();
+
     protected:
         CatalogItemArray m_items;
 
@@ -638,6 +710,17 @@ class Catalog
 
         std::shared_ptr<CloudSyncDestination> m_cloudSync;
         std::shared_ptr<SideloadedCatalogData> m_sideloaded;
+
+    private:
+        // Incremented by MarkItemsChanged()
+        unsigned m_itemsGeneration = 1;
+
+        // Running maximum of items' line numbers, built lazily for
+        // FindItemIndexByLine(); it is sorted (and thus searchable) even if
+        // line numbers aren't monotonic. m_lineIndexGeneration is
+        // m_itemsGeneration at the time the index was built.
+        std::vector<int> m_lineIndex;
+        unsigned m_lineIndexGeneration = 0;
 };
 
 #endif // Poedit_catalog_h
@@ -0,0 +1,614 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "catalog_cache.h"
+
+#include "concurrency.h"
+#include "edapp.h"
+#include "utility.h"
+#include "version.h"
+
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/thread.h>
+#include <wx/utils.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+
+// Files smaller than this are parsed quickly enough not to need caching
+const uint64_t MIN_CACHED_FILE_SIZE = 512 * 1024;
+
+// Maximum number of cached catalogs kept, least recently stored are removed first
+const size_t MAX_CACHED_FILES = 64;
+
+// Identifies cache files; bump the version whenever their layout changes
+const char CACHE_MAGIC[] = "PoeditCatalogCache";
+const uint32_t CACHE_FORMAT_VERSION = 3;
+
+
+wxString GetCacheDir()
+{
+    return PoeditApp::GetCacheDir("Catalogs");
+}
+
+wxString GetCacheFileName(const wxString& path)
+{
+    const auto hash = CatalogCache::HashContent(path.utf8_string());
+    return GetCacheDir() + wxFILE_SEP_PATH + wxString::Format("%016llx.bin", (unsigned long long)hash);
+}
+
+
+/// Identification of a file's content that the cache is valid for
+struct FileKey
+{
+    wxString path;
+    uint64_t size = 0;
+    int64_t modTime = 0;
+    uint64_t contentHash = 0;
+
+    /// Initializes everything except contentHash
+    bool InitFromStat(const wxString& filename)
+    {
+        wxFileName fn(filename);
+        fn.MakeAbsolute();
+        path = fn.GetFullPath();
+
+        const auto fileSize = fn.GetSize();
+        const auto fileTime = fn.GetModificationTime();
+        if (fileSize == wxInvalidSize || !fileTime.IsValid())
+            return false;
+        size = fileSize.GetValue();
+        modTime = fileTime.GetValue().GetValue();
+        return true;
+    }
+
+    bool Init(const wxString& filename)
+    {
+        if (!InitFromStat(filename))
+            return false;
+
+        MappedFile content(filename);
+        if (!content.IsOk() || content.size() != size)
+            return false;
+        contentHash = CatalogCache::HashContent(content.view());
+        return true;
+    }
+
+    bool operator==(const FileKey& other) const
+    {
+        return size == other.size && modTime == other.modTime && contentHash == other.contentHash && path == other.path;
+    }
+};
+
+
+/// Serializes data into a buffer in native byte order
+class CacheWriter
+{
+public:
+    void Raw(const void *data, size_t size) { m_data.append(static_cast<const char*>(data), size); }
+
+    void U32(uint32_t v) { Raw(&v, sizeof(v)); }
+    void U64(uint64_t v) { Raw(&v, sizeof(v)); }
+    void I32(int32_t v)  { Raw(&v, sizeof(v)); }
+    void I64(int64_t v)  { Raw(&v, sizeof(v)); }
+    void Bool(bool v)    { U32(v ? 1 : 0); }
+
+    void Str(std::string_view s)
+    {
+        U32((uint32_t)s.size());
+        Raw(s.data(), s.size());
+    }
+
+    void Str(const wxString& s) { Str(s.utf8_string()); }
+
+    void Strs(const wxArrayString& arr)
+    {
+        U32((uint32_t)arr.size());
+        for (auto& s: arr)
+            Str(s);
+    }
+
+    std::string& Data() { return m_data; }
+
+private:
+    std::string m_data;
+};
+
+
+/// Reads data written by CacheWriter; any error, e.g. truncated data, makes the reader not OK
+class CacheReader
+{
+public:
+    explicit CacheReader(std::string_view data) : m_data(data) {}
+
+    bool IsOk() const { return m_ok; }
+
+    bool Raw(void *out, size_t size)
+    {
+        if (!m_ok || m_data.size() < size)
+        {
+            m_ok = false;
+            return false;
+        }
+        memcpy(out, m_data.data(), size);
+        m_data.remove_prefix(size);
+        return true;
+    }
+
+    template<typename T>
+    T Value()
+    {
+        T v = T();
+        Raw(&v, sizeof(v));
+        return v;
+    }
+
+    uint32_t U32() { return Value<uint32_t>(); }
+    uint64_t U64() { return Value<uint64_t>(); }
+    int32_t I32()  { return Value<int32_t>(); }
+    int64_t I64()  { return Value<int64_t>(); }
+    bool Bool()    { return U32() != 0; }
+
+    std::string_view StrView()
+    {
+        const uint32_t len = U32();
+        if (!m_ok || m_data.size() < len)
+        {
+            m_ok = false;
+            return std::string_view();
+        }
+        auto s = m_data.substr(0, len);
+        m_data.remove_prefix(len);
+        return s;
+    }
+
+    wxString Str()
+    {
+        auto s = StrView();
+        return wxString::FromUTF8(s.data(), s.size());
+    }
+
+    wxArrayString Strs()
+    {
+        wxArrayString arr;
+        const uint32_t count = U32();
+        if (!m_ok || count > m_data.size() / sizeof(uint32_t))  // guard against corrupted counts
+        {
+            m_ok = false;
+            return arr;
+        }
+        arr.reserve(count);
+        for (uint32_t i = 0; i < count && m_ok; i++)
+            arr.push_back(Str());
+        return arr;
+    }
+
+    /// Checks if @a count items of at least @a minSize bytes can follow
+    bool CanHold(uint32_t count, size_t minSize)
+    {
+        if (m_ok && count > m_data.size() / minSize)
+            m_ok = false;
+        return m_ok;
+    }
+
+private:
+    std::string_view m_data;
+    bool m_ok = true;
+};
+
+
+void WriteKey(CacheWriter& w, const FileKey& key)
+{
+    w.Raw(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    w.U32(CACHE_FORMAT_VERSION);
+    w.Str(std::string(POEDIT_VERSION));
+    w.Str(key.path);
+    w.U64(key.size);
+    w.I64(key.modTime);
+    w.U64(key.contentHash);
+}
+
+bool ReadKey(CacheReader& r, FileKey& key)
+{
+    char magic[sizeof(CACHE_MAGIC)];
+    if (!r.Raw(magic, sizeof(magic)) || memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0)
+        return false;
+    if (r.U32() != CACHE_FORMAT_VERSION || r.StrView() != POEDIT_VERSION)
+        return false;
+    key.path = r.Str();
+    key.size = r.U64();
+    key.modTime = r.I64();
+    key.contentHash = r.U64();
+    return r.IsOk();
+}
+
+
+void WriteCacheFile(const wxString& cacheFile, const std::string& data)
+{
+    wxLogNull null;
+
+    const wxString dir = GetCacheDir();
+    if (!wxFileName::Mkdir(dir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+        return;
+
+    // write atomically, readers must never see partially written file; the
+    // temporary file is unique, the same file may be stored concurrently:
+    const wxString tempFile = wxString::Format("%s.%lu.%lu.tmp", cacheFile,
+                                               (unsigned long)wxGetProcessId(),
+                                               (unsigned long)wxThread::GetCurrentId());
+    {
+        wxFile f;
+        if (!f.Create(tempFile, /*overwrite=*/true) || f.Write(data.data(), data.size()) != data.size() || !f.Close())
+        {
+            wxRemoveFile(tempFile);
+            return;
+        }
+    }
+    if (!wxRenameFile(tempFile, cacheFile, /*overwrite=*/true))
+    {
+        wxRemoveFile(tempFile);
+        return;
+    }
+
+    // prune the cache if it grew too large:
+    wxArrayString files;
+    wxDir::GetAllFiles(dir, &files, "*.bin", wxDIR_FILES);
+    if (files.size() <= MAX_CACHED_FILES)
+        return;
+
+    std::vector<std::pair<time_t, wxString>> byAge;
+    for (auto& f: files)
+        byAge.emplace_back(wxFileModificationTime(f), f);
+    std::sort(byAge.begin(), byAge.end());
+    for (size_t i = 0; i < byAge.size() - MAX_CACHED_FILES; i++)
+        wxRemoveFile(byAge[i].second);
+}
+
+} // anonymous namespace
+
+
+uint64_t CatalogCache::HashContent(std::string_view data)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c: data)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+bool CatalogCache::IsWorthCaching(uint64_t fileSize)
+{
+    return fileSize >= MIN_CACHED_FILE_SIZE;
+}
+
+
+void CatalogCache::Store(POCatalog& cat)
+{
+    if (cat.GetFileType() != Catalog::Type::PO && cat.GetFileType() != Catalog::Type::POT)
+        return;
+    if (!cat.m_loadedContentHash)
+        return;  // not loaded from a file worth caching
+
+    FileKey key;
+    if (!key.InitFromStat(cat.GetFileName()) || !IsWorthCaching(key.size))
+        return;
+    key.contentHash = cat.m_loadedContentHash;
+
+    // Take a copy of the data, the catalog may be modified before it's written.
+    // Secondary data are immutable and shared, so copying them is cheap:
+    struct ItemData
+    {
+        int32_t id, lineNum;
+        wxString string;
+        bool hasPlural, hasContext;
+        InternedString plural, context, comment;
+        wxArrayString translations;
+        wxString flags;
+        bool isDeferred;
+        POCatalogItem::DeferredLines deferredLines;
+        InternedStringArray extractedComments, oldMsgid, references;
+    };
+
+    struct Snapshot
+    {
+        uint32_t fileType;
+        wxString charset, header, headerComment;
+        std::string sourceLanguage;
+        bool sourceIsSymbolicID;
+        int32_t fileCRLF, fileWrappingWidth;
+        bool hasPluralItems;
+        std::vector<ItemData> items;
+        POCatalogDeletedDataArray deletedItems;
+        std::unique_ptr<POCatalog::FileLayout> layout;
+    };
+
+    auto snap = std::make_shared<Snapshot>();
+    snap->fileType = (uint32_t)cat.m_fileType;
+    snap->charset = cat.m_header.Charset;
+    snap->header = UnescapeCString(cat.m_header.ToString());
+    snap->headerComment = cat.m_header.Comment;
+    snap->sourceLanguage = cat.m_sourceLanguage.Code();
+    snap->sourceIsSymbolicID = cat.m_sourceIsSymbolicID;
+    snap->fileCRLF = cat.m_fileCRLF;
+    snap->fileWrappingWidth = cat.m_fileWrappingWidth;
+    snap->hasPluralItems = cat.m_hasPluralItems;
+
+    snap->items.reserve(cat.m_items.size());
+    for (auto& item_: cat.m_items)
+    {
+        auto& item = static_cast<POCatalogItem&>(*item_);
+        ItemData d;
+        d.id = item.m_id;
+        d.lineNum = item.m_lineNum;
+        d.string = item.m_string;
+        d.hasPlural = item.m_hasPlural;
+        d.hasContext = item.m_hasContext;
+        d.plural = item.m_plural;
+        d.context = item.m_context;
+        d.comment = item.m_comment;
+        d.translations = item.m_translations;
+        d.flags = item.GetFlags();
+        // keep deferred data as-is, so that caching doesn't need to parse it:
+        d.isDeferred = item.HasDeferredData();
+        if (d.isDeferred)
+        {
+            d.deferredLines = item.m_deferredLines;
+        }
+        else
+        {
+            d.extractedComments = item.m_extractedComments;
+            d.oldMsgid = item.m_oldMsgid;
+            d.references = item.m_references;
+        }
+        snap->items.push_back(std::move(d));
+    }
+
+    snap->deletedItems = cat.m_deletedItems;
+    if (cat.m_fileLayout)
+        snap->layout.reset(new POCatalog::FileLayout(*cat.m_fileLayout));
+
+    // Serializing and writing is done in the background so that it doesn't slow down opening:
+    const wxString cacheFile = GetCacheFileName(key.path);
+    dispatch::async([key, snap, cacheFile]
+    {
+        CacheWriter w;
+        w.Data().reserve(key.size);
+        WriteKey(w, key);
+
+        // catalog-wide data:
+        w.U32(snap->fileType);
+        w.Str(snap->charset);
+        w.Str(snap->header);
+        w.Str(snap->headerComment);
+        w.Str(snap->sourceLanguage);
+        w.Bool(snap->sourceIsSymbolicID);
+        w.I32(snap->fileCRLF);
+        w.I32(snap->fileWrappingWidth);
+        w.Bool(snap->hasPluralItems);
+
+        w.U32((uint32_t)snap->items.size());
+        for (auto& item: snap->items)
+        {
+            w.I32(item.id);
+            w.I32(item.lineNum);
+            w.Str(item.string);
+            w.Bool(item.hasPlural);
+            w.Str(StringPool::Get(item.plural));
+            w.Bool(item.hasContext);
+            w.Str(StringPool::Get(item.context));
+            w.Strs(item.translations);
+            w.Str(item.flags);
+            w.Str(StringPool::Get(item.comment));
+
+            w.Bool(item.isDeferred);
+            if (item.isDeferred)
+            {
+                auto& lines = item.deferredLines;
+                w.Str(std::string_view(*lines.buffer).substr(lines.offset, lines.length));
+                w.U32(lines.references);
+                w.U32(lines.extractedComments);
+                w.U32(lines.oldMsgid);
+            }
+            else
+            {
+                w.Strs(StringPool::Get(item.extractedComments));
+                w.Strs(StringPool::Get(item.oldMsgid));
+                w.Strs(StringPool::Get(item.references));
+            }
+        }
+
+        w.U32((uint32_t)snap->deletedItems.size());
+        for (auto& d: snap->deletedItems)
+        {
+            w.I32(d.GetLineNumber());
+            w.Strs(d.GetDeletedLines());
+            w.Strs(d.GetRawReferences());
+            w.Strs(d.GetExtractedComments());
+            w.Str(d.GetFlags());
+            w.Str(d.GetComment());
+        }
+
+        auto& layout = snap->layout;
+        w.Bool(layout != nullptr);
+        if (layout)
+        {
+            w.I32(layout->crlf);
+            w.I32(layout->wrapping);
+            w.U32(layout->pluralsCount);
+            w.U64(layout->header.offset);
+            w.U64(layout->header.length);
+            for (auto& span: layout->items)
+            {
+                w.U64(span.offset);
+                w.U64(span.length);
+            }
+        }
+
+        WriteCacheFile(cacheFile, w.Data());
+    });
+}
+
+
+POCatalogPtr CatalogCache::Load(const wxString& filename)
+{
+    wxFileName fn(filename);
+    fn.MakeAbsolute();
+    const wxString cacheFile = GetCacheFileName(fn.GetFullPath());
+    if (!wxFileExists(cacheFile))
+        return nullptr;
+
+    MappedFile data(cacheFile);
+    if (!data.IsOk())
+        return nullptr;
+
+    CacheReader r(data.view());
+    FileKey cachedKey, key;
+    if (!ReadKey(r, cachedKey) || !key.Init(filename) || !(key == cachedKey))
+        return nullptr;
+
+    POCatalogPtr cat(new POCatalog((Catalog::Type)r.U32()));
+    if (cat->m_fileType != Catalog::Type::PO && cat->m_fileType != Catalog::Type::POT)
+        return nullptr;
+
+    cat->m_header.Charset = r.Str();
+    cat->m_header.FromString(r.Str());
+    cat->m_header.Comment = r.Str();
+    cat->m_sourceLanguage = Language::TryParse(std::string(r.StrView()));
+    cat->m_sourceIsSymbolicID = r.Bool();
+    cat->m_fileCRLF = (wxTextFileType)r.I32();
+    cat->m_fileWrappingWidth = r.I32();
+    cat->m_hasPluralItems = r.Bool();
+
+    const uint32_t itemsCount = r.U32();
+    if (!r.CanHold(itemsCount, 16))
+        return nullptr;
+    StringPool pool;
+    auto deferredBuffer = std::make_shared<std::string>();
+    cat->m_items.reserve(itemsCount);
+    for (uint32_t i = 0; i < itemsCount && r.IsOk(); i++)
+    {
+        auto item = std::make_shared<POCatalogItem>();
+        item->SetId(r.I32());
+        item->SetLineNumber(r.I32());
+        item->SetString(r.Str());
+        const bool hasPlural = r.Bool();
+        auto plural = r.Str();
+        if (hasPlural)
+            item->SetPluralString(plural);
+        const bool hasContext = r.Bool();
+        auto context = r.Str();
+        if (hasContext)
+            item->SetContext(context);
+        item->SetTranslations(r.Strs());
+        item->SetFlags(r.Str());
+        item->m_comment = StringPool::Wrap(r.Str());
+        if (r.Bool())
+        {
+            POCatalogItem::DeferredLines lines;
+            auto raw = r.StrView();
+            lines.buffer = deferredBuffer;
+            lines.offset = deferredBuffer->size();
+            lines.length = raw.size();
+            lines.references = r.U32();
+            lines.extractedComments = r.U32();
+            lines.oldMsgid = r.U32();
+            const size_t linesCount = (size_t)lines.references + lines.extractedComments + lines.oldMsgid;
+            if (!r.IsOk() || (size_t)std::count(raw.begin(), raw.end(), '\n') != linesCount)
+                return nullptr;
+            deferredBuffer->append(raw);
+            item->SetDeferredLines(std::move(lines));
+        }
+        else
+        {
+            item->SetExtractedComments(r.Strs());
+            item->SetOldMsgid(r.Strs());
+            item->SetRawReferences(r.Strs());
+        }
+        item->InternData(pool);
+        item->ClearDirty();
+        cat->AppendItem(item);
+    }
+
+    const uint32_t deletedCount = r.U32();
+    if (!r.CanHold(deletedCount, 16))
+        return nullptr;
+    for (uint32_t i = 0; i < deletedCount && r.IsOk(); i++)
+    {
+        POCatalogDeletedData d;
+        d.SetLineNumber(r.I32());
+        d.SetDeletedLines(r.Strs());
+        for (auto& ref: r.Strs())
+            d.AddReference(ref);
+        for (auto& extracted: r.Strs())
+            d.AddExtractedComments(extracted);
+        d.SetFlags(r.Str());
+        d.SetComment(r.Str());
+        cat->m_deletedItems.push_back(d);
+    }
+
+    if (r.Bool())
+    {
+        std::unique_ptr<POCatalog::FileLayout> layout(new POCatalog::FileLayout);
+        layout->crlf = (wxTextFileType)r.I32();
+        layout->wrapping = r.I32();
+        layout->pluralsCount = r.U32();
+        layout->header.offset = (size_t)r.U64();
+        layout->header.length = (size_t)r.U64();
+        if (!r.CanHold(itemsCount, 16))
+            return nullptr;
+        layout->items.resize(itemsCount);
+        for (auto& span: layout->items)
+        {
+            span.offset = (size_t)r.U64();
+            span.length = (size_t)r.U64();
+        }
+        if (r.IsOk())
+            cat->SetFileLayout(filename, std::move(layout));
+    }
+
+    if (!r.IsOk())
+    {
+        wxLogTrace("poedit", "cached data for %s are corrupted", filename);
+        wxRemoveFile(cacheFile);
+        return nullptr;
+    }
+
+    wxLogTrace("poedit", "loaded %s from cache", filename);
+    return cat;
+}
@@ -0,0 +1,71 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_catalog_cache_h
+#define Poedit_catalog_cache_h
+
+#include "catalog_po.h"
+
+#include <wx/string.h>
+
+#include <cstdint>
+#include <string_view>
+
+
+/**
+    On-disk cache of parsed catalogs.
+
+    Large PO files are frequently reopened without being modified in the
+    meantime. Their parsed state, as it is after Catalog::PostCreation()
+    (i.e. including detected languages), is stored in compact binary form in
+    the user's cache directory, so that reopening them only needs to read it
+    back instead of parsing the file and running detection again.
+
+    Cached data are keyed by the file's path and validated against its size,
+    modification time and a hash of its content.
+ */
+class CatalogCache
+{
+public:
+    /// Returns cached catalog for @a filename, if there's a valid one.
+    static POCatalogPtr Load(const wxString& filename);
+
+    /**
+        Stores just loaded @a catalog in the cache, if it is worth it.
+
+        Only a snapshot of the catalog's data is taken synchronously, it is
+        serialized and written in the background. Uses content hash computed
+        by POCatalog::Load(), so the file isn't read again.
+     */
+    static void Store(POCatalog& catalog);
+
+    /// Is a file of given size large enough to benefit from caching?
+    static bool IsWorthCaching(uint64_t fileSize);
+
+    /// Hash of file content used to validate cached data; stable across builds.
+    static uint64_t HashContent(std::string_view data);
+};
+
+#endif // Poedit_catalog_cache_h
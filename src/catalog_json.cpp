@@ -34,10 +34,12 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <map>
 #include <memory>
 #include <sstream>
+#include <string_view>
 
 
 namespace
@@ -45,17 +47,17 @@ namespace
 
 // Try to determine JSON file's formatting, i.e. line endings and identation, by inspecting the
 // beginning of the file.
-void DetectFileFormatting(std::ifstream& f, int& indent, char& indent_char, bool& dos_line_endings)
+void DetectFileFormatting(std::string_view text, int& indent, char& indent_char, bool& dos_line_endings)
 {
     // fallback defaults: compact representation with no indentation
     indent = -1;
     indent_char = ' ';
     dos_line_endings = false;
 
-    for (int counter = 0; counter < 100; ++counter)
+    for (size_t i = 0; i < text.size() && i < 100; ++i)
     {
-        auto c = f.get();
-        if (c == '\r' && f.peek() == '\n')
+        auto c = text[i];
+        if (c == '\r' && i + 1 < text.size() && text[i + 1] == '\n')
         {
             dos_line_endings = true;
         }
@@ -81,6 +83,288 @@ void DetectFileFormatting(std::ifstream& f, int& indent, char& indent_char, bool
     }
 }
 
+
+/**
+    SAX-style scanner for JSON key-value files.
+
+    Unlike nlohmann::json's SAX parser, it reports byte spans of values, so
+    that modified values can be spliced back into the original text. It only
+    supports what simple translation files consist of: objects with string or
+    null values. Anything else (arrays, numbers, booleans) as well as malformed
+    input makes Scan() fail and the caller should fall back to DOM parsing,
+    which also provides proper error messages.
+
+    The handler must implement these methods, returning false to abort:
+
+        bool OnObjectStart();
+        bool OnObjectEnd();
+        bool OnKey(std::string&& key);
+        bool OnValue(std::string&& value, bool isNull, size_t offset, size_t length);
+ */
+template<typename Handler>
+class JSONSpanScanner
+{
+public:
+    JSONSpanScanner(std::string_view text, Handler& handler) : m_text(text), m_handler(handler) {}
+
+    bool Scan()
+    {
+        m_pos = 0;
+        if (m_text.substr(0, 3) == "\xEF\xBB\xBF")
+            m_pos = 3; // skip UTF-8 BOM
+
+        SkipWhitespace();
+        if (!ParseValue(0))
+            return false;
+        SkipWhitespace();
+        return m_pos == m_text.size();
+    }
+
+private:
+    static const int MAX_DEPTH = 256;
+
+    bool AtChar(char c) const { return m_pos < m_text.size() && m_text[m_pos] == c; }
+
+    void SkipWhitespace()
+    {
+        while (m_pos < m_text.size())
+        {
+            const char c = m_text[m_pos];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+                break;
+            ++m_pos;
+        }
+    }
+
+    bool ParseValue(int depth)
+    {
+        if (depth > MAX_DEPTH || m_pos >= m_text.size())
+            return false;
+
+        const size_t start = m_pos;
+        switch (m_text[m_pos])
+        {
+            case '{':
+                return ParseObject(depth);
+
+            case '"':
+            {
+                std::string value;
+                if (!ParseString(value))
+                    return false;
+                return m_handler.OnValue(std::move(value), false, start, m_pos - start);
+            }
+
+            case 'n':
+            {
+                if (m_text.substr(m_pos, 4) != "null")
+                    return false;
+                m_pos += 4;
+                return m_handler.OnValue(std::string(), true, start, 4);
+            }
+
+            default:
+                return false; // not supported, let the DOM parser handle it
+        }
+    }
+
+    bool ParseObject(int depth)
+    {
+        ++m_pos; // '{'
+        if (!m_handler.OnObjectStart())
+            return false;
+
+        SkipWhitespace();
+        if (AtChar('}'))
+        {
+            ++m_pos;
+            return m_handler.OnObjectEnd();
+        }
+
+        for (;;)
+        {
+            SkipWhitespace();
+            if (!AtChar('"'))
+                return false;
+            std::string key;
+            if (!ParseString(key) || !m_handler.OnKey(std::move(key)))
+                return false;
+
+            SkipWhitespace();
+            if (!AtChar(':'))
+                return false;
+            ++m_pos;
+            SkipWhitespace();
+
+            if (!ParseValue(depth + 1))
+                return false;
+
+            SkipWhitespace();
+            if (AtChar(','))
+            {
+                ++m_pos;
+            }
+            else if (AtChar('}'))
+            {
+                ++m_pos;
+                return m_handler.OnObjectEnd();
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+
+    bool ParseString(std::string& out)
+    {
+        ++m_pos; // opening '"'
+        for (;;)
+        {
+            // copy runs of unescaped characters at once:
+            const size_t runStart = m_pos;
+            while (m_pos < m_text.size())
+            {
+                const unsigned char c = m_text[m_pos];
+                if (c == '"' || c == '\\' || c < 0x20)
+                    break;
+                if (c < 0x80)
+                {
+                    ++m_pos;
+                }
+                else
+                {
+                    const size_t len = UTF8SequenceLength(m_pos);
+                    if (!len)
+                        return false;
+                    m_pos += len;
+                }
+            }
+            out.append(m_text.data() + runStart, m_pos - runStart);
+
+            if (m_pos >= m_text.size())
+                return false;
+            const char c = m_text[m_pos++];
+            if (c == '"')
+                return true;
+            if (c != '\\' || m_pos >= m_text.size())
+                return false; // unescaped control character or truncated input
+
+            switch (m_text[m_pos++])
+            {
+                case '"':  out += '"';  break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/';  break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u':
+                {
+                    uint32_t cp;
+                    if (!ParseHex4(cp))
+                        return false;
+                    if (cp >= 0xD800 && cp <= 0xDBFF)
+                    {
+                        // high surrogate must be followed by a low one
+                        uint32_t low;
+                        if (m_text.substr(m_pos, 2) != "\\u")
+                            return false;
+                        m_pos += 2;
+                        if (!ParseHex4(low) || low < 0xDC00 || low > 0xDFFF)
+                            return false;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    else if (cp >= 0xDC00 && cp <= 0xDFFF)
+                    {
+                        return false;
+                    }
+                    AppendUTF8(out, cp);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+    }
+
+    bool ParseHex4(uint32_t& cp)
+    {
+        if (m_pos + 4 > m_text.size())
+            return false;
+        cp = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const char c = m_text[m_pos++];
+            cp <<= 4;
+            if (c >= '0' && c <= '9')
+                cp |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                cp |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                cp |= c - 'A' + 10;
+            else
+                return false;
+        }
+        return true;
+    }
+
+    // Returns length of valid UTF-8 sequence starting at @a pos or 0 if invalid.
+    size_t UTF8SequenceLength(size_t pos) const
+    {
+        auto byte = [=](size_t i) -> unsigned { return pos + i < m_text.size() ? (unsigned char)m_text[pos + i] : 0; };
+        auto cont = [&](size_t i, unsigned lo = 0x80, unsigned hi = 0xBF) { auto b = byte(i); return b >= lo && b <= hi; };
+
+        const unsigned c = byte(0);
+        if (c >= 0xC2 && c <= 0xDF)
+            return cont(1) ? 2 : 0;
+        if (c == 0xE0)
+            return cont(1, 0xA0) && cont(2) ? 3 : 0;
+        if ((c >= 0xE1 && c <= 0xEC) || c == 0xEE || c == 0xEF)
+            return cont(1) && cont(2) ? 3 : 0;
+        if (c == 0xED)
+            return cont(1, 0x80, 0x9F) && cont(2) ? 3 : 0;
+        if (c == 0xF0)
+            return cont(1, 0x90) && cont(2) && cont(3) ? 4 : 0;
+        if (c >= 0xF1 && c <= 0xF3)
+            return cont(1) && cont(2) && cont(3) ? 4 : 0;
+        if (c == 0xF4)
+            return cont(1, 0x80, 0x8F) && cont(2) && cont(3) ? 4 : 0;
+        return 0;
+    }
+
+    static void AppendUTF8(std::string& out, uint32_t cp)
+    {
+        if (cp < 0x80)
+        {
+            out += (char)cp;
+        }
+        else if (cp < 0x800)
+        {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    std::string_view m_text;
+    size_t m_pos = 0;
+    Handler& m_handler;
+};
+
 } // anonymous namespace
 
 
@@ -121,16 +405,27 @@ std::shared_ptr<JSONCatalog> JSONCatalog::Open(const wxString& filename)
     try
     {
         const auto ext = str::to_utf8(wxFileName(filename).GetExt().Lower());
-        std::ifstream f(filename.fn_str(), std::ios::binary);
-        auto data = json_t::parse(f);
 
-        auto cat = CreateForJSON(std::move(data), ext);
+        std::string text;
+        {
+            MappedFile file(filename);
+            if (file.IsOk())
+                text.assign(file.data(), file.size());
+        }
+
+        // Plain key-value files, which are the most common and can be huge, are loaded
+        // in a single pass without building DOM; other variants need the DOM:
+        auto cat = CreateForText(text, ext);
         if (!cat)
-            BOOST_THROW_EXCEPTION(JSONUnrecognizedFileException());
+        {
+            auto data = json_t::parse(text);
 
-        f.clear();
-        f.seekg(0, std::ios::beg);
-        DetectFileFormatting(f, cat->m_formatting.indent, cat->m_formatting.indent_char, cat->m_formatting.dos_line_endings);
+            cat = CreateForJSON(std::move(data), ext);
+            if (!cat)
+                BOOST_THROW_EXCEPTION(JSONUnrecognizedFileException());
+
+            DetectFileFormatting(text, cat->m_formatting.indent, cat->m_formatting.indent_char, cat->m_formatting.dos_line_endings);
+        }
 
         cat->Parse();
 
@@ -158,7 +453,7 @@ bool JSONCatalog::Save(const wxString& filename, bool /*save_mo*/,
 
     {
         std::ofstream f(tempfile.FileName().fn_str(), std::ios::binary);
-        f << SaveToBuffer();
+        SaveToStream(f);
     }
 
     if ( !tempfile.Commit() )
@@ -174,11 +469,11 @@ bool JSONCatalog::Save(const wxString& filename, bool /*save_mo*/,
 }
 
 
-std::string JSONCatalog::SaveToBuffer()
+bool JSONCatalog::SaveToStream(std::ostream& out)
 {
     auto s = m_doc.dump(m_formatting.indent, m_formatting.indent_char, /*ensure_ascii=*/false);
     if (s.empty())
-        return s; // shouldn't be possible...
+        return false; // shouldn't be possible...
 
     // all POSIX text files must end in newline, but json::dump() doesn't produce it
     if (s.back() != '\n')
@@ -188,102 +483,207 @@ std::string JSONCatalog::SaveToBuffer()
     {
         boost::replace_all(s, "\n", "\r\n");
     }
-    return s;
+
+    out.write(s.data(), s.size());
+    return out.good();
 }
 
 
-class GenericJSONItem : public JSONCatalogItem
+// Generic key-value JSON files (possibly nested) are loaded without DOM, with items
+// referring to their values' location in the original text, where any modified
+// translations are spliced on save.
+
+class GenericJSONItem : public CatalogItem
 {
 public:
-    GenericJSONItem(int id, const std::string& key, json_t& node) : JSONCatalogItem(id, node)
+    GenericJSONItem(int id, const std::string& key, const std::string& value, size_t offset, size_t length)
+        : m_offset(offset), m_length(length), m_modified(false)
     {
+        m_id = id;
+        m_isFuzzy = false; // not supported
+
         m_string = str::to_wx(key);
-        if (node.is_null())
-        {
-            m_translations.push_back(wxString());
-            m_isTranslated = false;
-        }
-        else
-        {
-            auto trans = str::to_wx(node.get<std::string>());
-            m_translations.push_back(trans);
-            m_isTranslated = !trans.empty();
-        }
+        auto trans = str::to_wx(value);
+        m_translations.push_back(trans);
+        m_isTranslated = !trans.empty();
     }
 
+    GenericJSONItem(const GenericJSONItem&) = delete;
+
+    wxArrayString GetReferences() const override { return wxArrayString(); }
+
     void UpdateInternalRepresentation() override
     {
-        m_node = str::to_utf8(GetTranslation());
+        m_modified = true;
     }
+
+    /// Position of the value (including quotes) in the original file
+    size_t GetOffset() const { return m_offset; }
+    size_t GetLength() const { return m_length; }
+
+    /// Was the value changed since loading, i.e. does it need to be written?
+    bool IsModified() const { return m_modified; }
+
+private:
+    size_t m_offset, m_length;
+    bool m_modified;
 };
 
 
 class GenericJSONCatalog : public JSONCatalog
 {
 public:
-    using JSONCatalog::JSONCatalog;
+    GenericJSONCatalog() : JSONCatalog(json_t()) {}
 
-    static bool SupportsFile(const json_t& doc)
+    /// Loads @a text if it is a plain key-value file, taking ownership of it; returns nullptr otherwise
+    static std::shared_ptr<GenericJSONCatalog> CreateFromText(std::string& text)
     {
-        // note that parsing may still fail, this is just pre-flight
-        return doc.is_object();
+        auto cat = std::make_shared<GenericJSONCatalog>();
+        Loader loader(*cat);
+        if (!JSONSpanScanner<Loader>(text, loader).Scan())
+            return nullptr;
+
+        cat->m_text = std::move(text);
+        return cat;
     }
 
     void Parse() override
     {
-        int id = 0;
-        ParseSubtree(id, m_doc, "");
-
+        // items were already created by CreateFromText()
         if (m_items.empty())
             BOOST_THROW_EXCEPTION(JSONUnrecognizedFileException());
     }
 
+    bool SaveToStream(std::ostream& out) override
+    {
+        std::vector<const GenericJSONItem*> modified;
+        for (auto& i: m_items)
+        {
+            auto item = static_cast<const GenericJSONItem*>(i.get());
+            if (item->IsModified())
+                modified.push_back(item);
+        }
+        std::sort(modified.begin(), modified.end(),
+                  [](auto a, auto b){ return a->GetOffset() < b->GetOffset(); });
+
+        // splice modified values into the original text, keeping its formatting intact:
+        size_t pos = 0;
+        for (auto item: modified)
+        {
+            out.write(m_text.data() + pos, item->GetOffset() - pos);
+            auto value = json_t(str::to_utf8(item->GetTranslation())).dump(-1, ' ', /*ensure_ascii=*/false);
+            out.write(value.data(), value.size());
+            pos = item->GetOffset() + item->GetLength();
+        }
+        out.write(m_text.data() + pos, m_text.size() - pos);
+
+        return out.good();
+    }
+
 private:
-    void ParseSubtree(int& id, json_t& node, const std::string& prefix)
+    // JSONSpanScanner handler that creates items for all string and null values
+    class Loader
     {
-        for (auto& el : node.items())
+    public:
+        Loader(GenericJSONCatalog& cat) : m_cat(cat) {}
+
+        bool OnObjectStart()
         {
-            auto& val = el.value();
-            if (val.is_string() || val.is_null())
+            if (m_depth > 0)
             {
-                m_items.push_back(std::make_shared<GenericJSONItem>(++id, prefix + el.key(), val));
+                m_pathLengths.push_back(m_path.size());
+                m_path += m_key;
+                m_path += '.';
             }
-            else if (val.is_object())
+            m_depth++;
+            return true;
+        }
+
+        bool OnObjectEnd()
+        {
+            if (--m_depth > 0)
             {
-                ParseSubtree(id, val, prefix + el.key() + ".");
+                m_path.resize(m_pathLengths.back());
+                m_pathLengths.pop_back();
             }
-            else
+            return true;
+        }
+
+        bool OnKey(std::string&& key)
+        {
+            // detect variants handled by specialized DOM-based classes:
+            if (m_depth == 1)
             {
-                BOOST_THROW_EXCEPTION(JSONUnrecognizedFileException());
+                if (key == "@@locale")
+                    return false; // FlutterCatalog
+                m_topLevelCount++;
             }
+            else if (m_depth == 2 && m_topLevelCount == 1 && key == "message")
+            {
+                return false; // WebExtensionCatalog
+            }
+
+            m_key = std::move(key);
+            return true;
         }
-    }
+
+        bool OnValue(std::string&& value, bool /*isNull*/, size_t offset, size_t length)
+        {
+            if (m_depth == 0)
+                return false; // must be an object
+            if (m_depth == 1 && m_key == "generator" && value == "Localazy")
+                return false; // LocalazyCatalog
+
+            m_cat.AppendItem(std::make_shared<GenericJSONItem>(++m_id, m_path + m_key, value, offset, length));
+            return true;
+        }
+
+    private:
+        GenericJSONCatalog& m_cat;
+        int m_id = 0;
+        int m_depth = 0;
+        size_t m_topLevelCount = 0;
+        std::string m_key;
+        std::string m_path; // key path prefix of the current object, e.g. "foo.bar."
+        std::vector<size_t> m_pathLengths;
+    };
+
+    std::string m_text;
 };
 
 
 // Support for Flutter ARB files:
 // https://github.com/google/app-resource-bundle/wiki/ApplicationResourceBundleSpecification
 
-class FlutterItem : public GenericJSONItem
+class FlutterItem : public JSONCatalogItem
 {
 public:
     FlutterItem(int id, const std::string& key, json_t& node, const json_t *metadata)
-        : GenericJSONItem(id, key, node), m_metadata(metadata)
+        : JSONCatalogItem(id, node), m_metadata(metadata)
     {
+        m_string = str::to_wx(key);
+        auto trans = str::to_wx(node.get<std::string>());
+        m_translations.push_back(trans);
+        m_isTranslated = !trans.empty();
+
         if (metadata)
         {
             if (metadata->contains("context"))
             {
-                m_hasContext = true;
-                m_context = str::to_wx(metadata->at("context").get<std::string>());
+                SetContext(str::to_wx(metadata->at("context").get<std::string>()));
             }
             if (metadata->contains("description"))
             {
-                m_extractedComments.push_back(str::to_wx(metadata->at("description").get<std::string>()));
+                AddExtractedComments(str::to_wx(metadata->at("description").get<std::string>()));
             }
         }
     }
 
+    void UpdateInternalRepresentation() override
+    {
+        m_node = str::to_utf8(GetTranslation());
+    }
+
 protected:
     const json_t *m_metadata;
 };
@@ -348,7 +748,7 @@ private:
             {
                 auto mi = metadata.find(key);
                 auto meta = (mi != metadata.end()) ? mi->second : nullptr;
-                m_items.push_back(std::make_shared<FlutterItem>(++id, prefix + el.key(), val, meta));
+                AppendItem(std::make_shared<FlutterItem>(++id, prefix + el.key(), val, meta));
             }
             else if (val.is_object())
             {
@@ -392,7 +792,7 @@ public:
             if (!val.is_object())
                 BOOST_THROW_EXCEPTION(JSONUnrecognizedFileException());
 
-            m_items.push_back(std::make_shared<Item>(++id, el.key(), val));
+            AppendItem(std::make_shared<Item>(++id, el.key(), val));
         }
 
         if (m_items.empty())
@@ -413,7 +813,7 @@ protected:
 
             auto desc = node.value("description", "");
             if (!desc.empty())
-                m_extractedComments.push_back(str::to_wx(desc));
+                AddExtractedComments(str::to_wx(desc));
         }
 
         void UpdateInternalRepresentation() override
@@ -460,7 +860,7 @@ public:
                 if (!tr.at("source").is_string())
                     continue;
 
-                m_items.push_back(std::make_shared<Item>(++id, filename, tr));
+                AppendItem(std::make_shared<Item>(++id, filename, tr));
             }
         }
     }
@@ -486,9 +886,9 @@ protected:
             if (node.contains("meta"))
             {
                 auto& meta = node["meta"];
-                m_moreFlags = str::to_wx(meta.value("placeholders", ""));
+                m_moreFlags = StringPool::Wrap(str::to_wx(meta.value("placeholders", "")));
                 if (meta.contains("key"))
-                    m_extractedComments.push_back("ID: " + str::to_wx(meta["key"].get<std::string>()));
+                    AddExtractedComments("ID: " + str::to_wx(meta["key"].get<std::string>()));
             }
 
             if (node.contains("context"))
@@ -497,15 +897,15 @@ protected:
                 auto desc = ctxt.value("description", "");
 
                 if (ctxt.contains("description"))
-                    m_extractedComments.push_back(str::to_wx(ctxt.at("description").get<std::string>()));
+                    AddExtractedComments(str::to_wx(ctxt.at("description").get<std::string>()));
 
                 if (ctxt.contains("screenshots"))
                 {
-                    if (!m_extractedComments.empty())
-                        m_extractedComments.push_back("");
-                    m_extractedComments.push_back(_("Screenshots:"));
+                    if (m_extractedComments)
+                        AddExtractedComments("");
+                    AddExtractedComments(_("Screenshots:"));
                     for (auto& link : ctxt.at("screenshots"))
-                        m_extractedComments.push_back(str::to_wx(link.get<std::string>()));
+                        AddExtractedComments(str::to_wx(link.get<std::string>()));
                 }
             }
         }
@@ -540,9 +940,17 @@ std::shared_ptr<JSONCatalog> JSONCatalog::CreateForJSON(json_t&& doc, const std:
     if (LocalazyCatalog::SupportsFile(doc))
         return std::shared_ptr<JSONCatalog>(new LocalazyCatalog(std::move(doc)));
 
-    // then fall back to generic:
-    if (GenericJSONCatalog::SupportsFile(doc))
-        return std::shared_ptr<JSONCatalog>(new GenericJSONCatalog(std::move(doc)));
-
+    // generic files are handled by CreateForText() and never need DOM
     return nullptr;
 }
+
+
+std::shared_ptr<JSONCatalog> JSONCatalog::CreateForText(std::string& text, const std::string& extension)
+{
+    // Flutter ARB files need DOM for metadata lookups, other specialized
+    // variants are detected and rejected during scanning:
+    if (extension == "arb")
+        return nullptr;
+
+    return GenericJSONCatalog::CreateFromText(text);
+}
@@ -79,7 +79,7 @@ public:
               ValidationResults& validation_results,
               CompilationStatus& mo_compilation_status) override;
 
-    std::string SaveToBuffer() override;
+    bool SaveToStream(std::ostream& out) override;
 
     Language GetLanguage() const override { return m_language; }
     void SetLanguage(Language lang) override { m_language = lang; }
@@ -91,6 +91,7 @@ protected:
 
 private:
     static std::shared_ptr<JSONCatalog> CreateForJSON(json_t&& doc, const std::string& extension);
+    static std::shared_ptr<JSONCatalog> CreateForText(std::string& text, const std::string& extension);
 
 protected:
     json_t m_doc;
@@ -25,16 +25,23 @@
 
 #include "catalog_po.h"
 
+#include "catalog_cache.h"
+#include "concurrency.h"
 #include "configuration.h"
 #include "errors.h"
 #include "extractors/extractor.h"
+#include "fuzzy_match.h"
 #include "gexecute.h"
+#include "gettext_checks.h"
 #include "str_helpers.h"
 #include "utility.h"
 #include "version.h"
 #include "language.h"
+#include "mo_compiler.h"
+#include "unicode_helpers.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <wx/utils.h>
 #include <wx/tokenzr.h>
 #include <wx/log.h>
@@ -45,11 +52,29 @@
 #include <wx/scopeguard.h>
 #include <wx/stdpaths.h>
 #include <wx/strconv.h>
-#include <wx/memtext.h>
+#include <wx/file.h>
 #include <wx/filename.h>
+#include <wx/hashmap.h>
+#include <wx/stopwatch.h>
 
+#include <map>
 #include <set>
 #include <algorithm>
+#include <fstream>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <unicode/uchar.h>
+#include <unicode/utf8.h>
+
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
 
 #ifdef __WXOSX__
 #import <Foundation/Foundation.h>
@@ -67,30 +92,67 @@
 namespace
 {
 
+inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool StartsWith(std::string_view s, std::string_view prefix)
+{
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+inline bool EndsWith(std::string_view s, std::string_view suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+inline std::string_view TrimRight(std::string_view s)
+{
+    while (!s.empty() && IsSpace(s.back()))
+        s.remove_suffix(1);
+    return s;
+}
+
+// Converts already validated UTF-8 data into wxString:
+inline wxString FromUTF8View(std::string_view s)
+{
+    return wxString::FromUTF8Unchecked(s.data(), s.size());
+}
+
+inline wxArrayString FromUTF8Views(const std::vector<std::string_view>& v)
+{
+    wxArrayString a;
+    a.reserve(v.size());
+    for (auto& s: v)
+        a.push_back(FromUTF8View(s));
+    return a;
+}
+
 // If input begins with pattern, fill output with end of input (without
 // pattern; strips trailing spaces) and return true.  Return false otherwise
 // and don't touch output. Is permissive about whitespace in the input:
 // a space (' ') in pattern will match any number of any whitespace characters
 // on that position in input.
-bool ReadParam(const wxString& input, const wxString& pattern, wxString& output, bool preserveWhitespace = false)
+bool ReadParam(std::string_view input, std::string_view pattern, std::string_view& output, bool preserveWhitespace = false)
 {
     if (input.size() < pattern.size())
         return false;
 
-    unsigned in_pos = 0;
-    unsigned pat_pos = 0;
+    size_t in_pos = 0;
+    size_t pat_pos = 0;
     while (pat_pos < pattern.size() && in_pos < input.size())
     {
-        const wxChar pat = pattern[pat_pos++];
+        const char pat = pattern[pat_pos++];
 
-        if (pat == _T(' '))
+        if (pat == ' ')
         {
-            if (!wxIsspace(input[in_pos++]))
+            if (!IsSpace(input[in_pos++]))
                 return false;
 
             if (!preserveWhitespace)
             {
-                while (wxIsspace(input[in_pos]))
+                while (in_pos < input.size() && IsSpace(input[in_pos]))
                 {
                     in_pos++;
                     if (in_pos == input.size())
@@ -109,131 +171,240 @@ bool ReadParam(const wxString& input, const wxString& pattern, wxString& output,
     if (pat_pos < pattern.size()) // pattern not fully matched
         return false;
 
-    output = input.Mid(in_pos);
+    output = input.substr(in_pos);
     if (!preserveWhitespace)
-        output.Trim(true); // trailing whitespace
+        output = TrimRight(output); // trailing whitespace
     return true;
 }
 
 
-// Checks if the file was loaded correctly, i.e. that non-empty lines
-// ended up non-empty in memory, after doing charset conversion in
-// wxTextFile. This detects for example files that claim they are in UTF-8
-// while in fact they are not.
-bool VerifyFileCharset(const wxTextFile& f, const wxString& filename,
-                       const wxString& charset)
+wxTextFileType GetDesiredCRLFFormat(wxTextFileType existingCRLF)
 {
-    wxTextFile f2;
-
-    if (!f2.Open(filename, wxConvISO8859_1))
-        return false;
-
-    if (f.GetLineCount() != f2.GetLineCount())
+    if (existingCRLF != wxTextFileType_None && wxConfigBase::Get()->ReadBool("keep_crlf", true))
     {
-        int linesCount = (int)f2.GetLineCount() - (int)f.GetLineCount();
-        wxLogError(wxPLURAL(L"%i line of file “%s” was not loaded correctly.",
-                            L"%i lines of file “%s” were not loaded correctly.",
-                            linesCount),
-                   linesCount,
-                   filename.c_str());
-        return false;
+        return existingCRLF;
+    }
+    else
+    {
+        wxString format = wxConfigBase::Get()->Read("crlf_format", "unix");
+        if (format == "win")
+            return wxTextFileType_Dos;
+        else /* "unix" or obsolete settings */
+            return wxTextFileType_Unix;
     }
+}
 
-    bool ok = true;
-    size_t cnt = f.GetLineCount();
-    for (size_t i = 0; i < cnt; i++)
+Language GetSpecifiedMsgidLanguage(const Catalog::HeaderData& header)
+{
+    auto x_srclang = header.GetHeader("X-Source-Language");
+    if (x_srclang.empty())
+        x_srclang = header.GetHeader("X-Loco-Source-Locale");
+    if (!x_srclang.empty())
     {
-        if (f[i].empty() && !f2[i].empty()) // wxMBConv conversion failed
-        {
-            wxLogError(
-                _(L"Line %d of file “%s” is corrupted (not valid %s data)."),
-                int(i), filename.c_str(), charset.c_str());
-            ok = false;
-        }
+        auto parsed = Language::TryParse(str::to_utf8(x_srclang));
+        if (parsed.IsValid())
+            return parsed;
     }
+    return Language();
+}
+
+} // anonymous namespace
+
+
+// ----------------------------------------------------------------------
+// Parsers
+// ----------------------------------------------------------------------
 
-    return ok;
+void POCatalogParser::Entry::Clear()
+{
+    msgid = msgid_plural = context = flags = comment = source = std::string_view();
+    translations.clear();
+    references.clear();
+    extractedComments.clear();
+    msgidOld.clear();
+    deletedLines.clear();
+    hasPlural = hasContext = false;
+    lineNumber = 0;
 }
 
 
-wxTextFileType GetFileCRLFFormat(wxTextFile& po_file)
+char *POCatalogParser::Arena::Allocate(size_t size)
 {
-    wxLogNull null;
-    auto crlf = po_file.GuessType();
+    static const size_t BLOCK_SIZE = 64 * 1024;
 
-    // Discard any unsupported setting. In particular, we ignore "Mac"
-    // line endings, because the ancient OS 9 systems aren't used anymore,
-    // OSX uses Unix ending *and* "Mac" endings break gettext tools. So if
-    // we encounter a catalog with "Mac" line endings, we silently convert
-    // it into Unix endings (i.e. the modern Mac).
-    if (crlf == wxTextFileType_Mac)
-        crlf = wxTextFileType_Unix;
-    if (crlf != wxTextFileType_Dos && crlf != wxTextFileType_Unix)
-        crlf = wxTextFileType_None;
-    return crlf;
+    if (size > m_available)
+    {
+        const size_t blockSize = std::max(size, BLOCK_SIZE);
+        m_blocks.emplace_back(new char[blockSize]);
+        m_current = m_blocks.back().get();
+        m_available = blockSize;
+    }
+
+    char *ptr = m_current;
+    m_current += size;
+    m_available -= size;
+    return ptr;
 }
 
-wxTextFileType GetDesiredCRLFFormat(wxTextFileType existingCRLF)
+
+std::string_view POCatalogParser::Unescape(const std::vector<std::string_view>& segments)
 {
-    if (existingCRLF != wxTextFileType_None && wxConfigBase::Get()->ReadBool("keep_crlf", true))
+    if (segments.size() == 1 && segments[0].find('\\') == std::string_view::npos)
+        return segments[0];  // common case, no need to copy anything
+
+    size_t length = 0;
+    for (auto& seg: segments)
+        length += seg.size();
+    if (length == 0)
+        return std::string_view();
+
+    // unescaped text is never longer than the escaped one:
+    char * const out = m_arena.Allocate(length);
+    char *o = out;
+    for (auto& seg: segments)
     {
-        return existingCRLF;
+        for (auto i = seg.begin(); i != seg.end(); ++i)
+        {
+            char c = *i;
+            if (c != '\\')
+            {
+                *o++ = c;
+                continue;
+            }
+
+            if (++i == seg.end())
+            {
+                *o++ = c;
+                break;
+            }
+
+            switch (*i)
+            {
+                case 'a': *o++ = '\a'; break;
+                case 'b': *o++ = '\b'; break;
+                case 'f': *o++ = '\f'; break;
+                case 'n': *o++ = '\n'; break;
+                case 'r': *o++ = '\r'; break;
+                case 't': *o++ = '\t'; break;
+                case 'v': *o++ = '\v'; break;
+                case '\\':
+                case '"':
+                case '\'':
+                case '?':
+                    *o++ = *i;
+                    break;
+                default:
+                    *o++ = c;
+                    *o++ = *i;
+                    break;
+            }
+        }
     }
-    else
+
+    return std::string_view(out, o - out);
+}
+
+
+std::string_view POCatalogParser::Join(const std::vector<std::string_view>& parts, char suffix)
+{
+    if (parts.empty())
+        return std::string_view();
+    if (parts.size() == 1 && !suffix)
+        return parts[0];
+
+    size_t length = 0;
+    for (auto& p: parts)
+        length += p.size() + (suffix ? 1 : 0);
+
+    char * const out = m_arena.Allocate(length);
+    char *o = out;
+    for (auto& p: parts)
     {
-        wxString format = wxConfigBase::Get()->Read("crlf_format", "unix");
-        if (format == "win")
-            return wxTextFileType_Dos;
-        else /* "unix" or obsolete settings */
-            return wxTextFileType_Unix;
+        std::copy(p.begin(), p.end(), o);
+        o += p.size();
+        if (suffix)
+            *o++ = suffix;
     }
+
+    return std::string_view(out, length);
 }
 
-} // anonymous namespace
 
+std::string_view POCatalogParser::ReadQuotedValue(std::string_view first, std::string_view& line)
+{
+    m_segments.clear();
+    if (!first.empty())
+        first.remove_suffix(1); // closing quote
+    m_segments.push_back(first);
+
+    while (!(line = ReadTextLine()).empty())
+    {
+        if (line.front() == '"' && line.back() == '"')
+        {
+            m_segments.push_back(line.size() >= 2 ? line.substr(1, line.size() - 2) : std::string_view());
+            PossibleWrappedLine();
+        }
+        else
+            break;
+    }
+
+    return Unescape(m_segments);
+}
 
-// ----------------------------------------------------------------------
-// Parsers
-// ----------------------------------------------------------------------
 
 bool POCatalogParser::Parse()
 {
-    static const wxString prefix_flags(wxS("#, "));
-    static const wxString prefix_flags_alt(wxS("#= "));
-    static const wxString prefix_autocomments(wxS("#. "));
-    static const wxString prefix_autocomments2(wxS("#.")); // account for empty auto comments
-    static const wxString prefix_references(wxS("#: "));
-    static const wxString prefix_prev_msgid(wxS("#| "));
-    static const wxString prefix_msgctxt(wxS("msgctxt \""));
-    static const wxString prefix_msgid(wxS("msgid \""));
-    static const wxString prefix_msgid_plural(wxS("msgid_plural \""));
-    static const wxString prefix_msgstr(wxS("msgstr \""));
-    static const wxString prefix_msgstr_plural(wxS("msgstr["));
-    static const wxString prefix_deleted(wxS("#~"));
-    static const wxString prefix_deleted_msgid(wxS("#~ msgid"));
-
-    if (m_textFile->GetLineCount() == 0)
+    static const std::string_view prefix_flags("#, ");
+    static const std::string_view prefix_flags_alt("#= ");
+    static const std::string_view prefix_autocomments("#. ");
+    static const std::string_view prefix_autocomments2("#."); // account for empty auto comments
+    static const std::string_view prefix_references("#: ");
+    static const std::string_view prefix_prev_msgid("#| ");
+    static const std::string_view prefix_msgctxt("msgctxt \"");
+    static const std::string_view prefix_msgid("msgid \"");
+    static const std::string_view prefix_msgid_plural("msgid_plural \"");
+    static const std::string_view prefix_msgstr("msgstr \"");
+    static const std::string_view prefix_msgstr_plural("msgstr[");
+    static const std::string_view prefix_deleted("#~");
+    static const std::string_view prefix_deleted_msgid("#~ msgid");
+    static const std::string_view prefix_flags_partial(", ");
+
+    if (m_data.empty())
         return false;
 
-    wxString line, dummy;
-    wxString mflags, mstr, msgid_plural, mcomment;
-    wxArrayString mrefs, mextractedcomments, mtranslations;
-    wxArrayString msgid_old;
-    bool has_plural = false;
-    bool has_context = false;
-    wxString msgctxt;
-    unsigned mlinenum = 0;
+    std::string_view line, dummy;
+    Entry entry;
+    std::vector<std::string_view> flags, comments;
+    std::string label_prefix;
+    size_t entryStart = 0;
+
+    // When an entry is finished, the next line was already read, so the
+    // entry ends where the previous line did:
+    auto finishEntry = [&]
+    {
+        entry.flags = Join(flags);
+        entry.comment = Join(comments, '\n');
+        entry.source = m_data.substr(entryStart, m_prevLineEnd - entryStart);
+    };
+    auto resetEntry = [&]
+    {
+        entry.Clear();
+        flags.clear();
+        comments.clear();
+        entryStart = m_lineStart;
+    };
 
-    line = m_textFile->GetFirstLine();
-    if (line.empty())
-        line = ReadTextLine();
+    line = ReadTextLine();
+    entryStart = m_lineStart;
 
     while (!line.empty())
     {
         // ignore empty special tags (except for extracted comments which we
         // DO want to preserve):
-        while (line.length() == 2 && *line.begin() == '#' && (line[1] == ',' || line[1] == '=' || line[1] == ':' || line[1] == '|'))
+        while (line.length() == 2 && line[0] == '#' && (line[1] == ',' || line[1] == '=' || line[1] == ':' || line[1] == '|'))
             line = ReadTextLine();
+        if (line.empty())
+            break;
 
         // flags:
         if (ReadParam(line, prefix_flags, dummy) || ReadParam(line, prefix_flags_alt, dummy))
@@ -241,16 +412,15 @@ bool POCatalogParser::Parse()
             // see https://lists.gnu.org/archive/html/bug-gettext/2025-06/msg00018.html for introduction of
             // the #= alt form. We currently take the approach of converting #= to #, on write, as msgcat
             // also does, but this is just the initial, interim implementation
-            static wxString prefix_flags_partial(wxS(", "));
-            mflags += prefix_flags_partial;
-            mflags += dummy;
+            flags.push_back(prefix_flags_partial);
+            flags.push_back(dummy);
             line = ReadTextLine();
         }
 
         // auto comments:
         else if (ReadParam(line, prefix_autocomments, dummy, /*preserveWhitespace=*/true) || ReadParam(line, prefix_autocomments2, dummy, /*preserveWhitespace=*/true))
         {
-            mextractedcomments.Add(dummy);
+            entry.extractedComments.push_back(dummy);
             line = ReadTextLine();
         }
 
@@ -259,190 +429,107 @@ bool POCatalogParser::Parse()
         {
             // Just store the references unmodified, we don't modify this
             // data anywhere.
-            mrefs.push_back(dummy);
+            entry.references.push_back(dummy);
             line = ReadTextLine();
         }
 
         // previous msgid value:
         else if (ReadParam(line, prefix_prev_msgid, dummy))
         {
-            msgid_old.Add(dummy);
+            entry.msgidOld.push_back(dummy);
             line = ReadTextLine();
         }
 
         // msgctxt:
         else if (ReadParam(line, prefix_msgctxt, dummy))
         {
-            has_context = true;
-            msgctxt = UnescapeCString(dummy.RemoveLast());
-            while (!(line = ReadTextLine()).empty())
-            {
-                if (line[0u] == _T('\t'))
-                    line.Remove(0, 1);
-                if (line[0u] == _T('"') && line.Last() == _T('"'))
-                {
-                    msgctxt += UnescapeCString(line.Mid(1, line.Length() - 2));
-                    PossibleWrappedLine();
-                }
-                else
-                    break;
-            }
+            entry.hasContext = true;
+            entry.context = ReadQuotedValue(dummy, line);
         }
 
         // msgid:
         else if (ReadParam(line, prefix_msgid, dummy))
         {
-            mstr = UnescapeCString(dummy.RemoveLast());
-            mlinenum = unsigned(m_textFile->GetCurrentLine() + 1);
-            while (!(line = ReadTextLine()).empty())
-            {
-                if (line[0u] == wxS('\t'))
-                    line.Remove(0, 1);
-                if (line[0u] == wxS('"') && line.Last() == wxS('"'))
-                {
-                    mstr += UnescapeCString(line.Mid(1, line.Length() - 2));
-                    PossibleWrappedLine();
-                }
-                else
-                    break;
-            }
+            entry.lineNumber = m_lineNumber;
+            entry.msgid = ReadQuotedValue(dummy, line);
         }
 
         // msgid_plural:
         else if (ReadParam(line, prefix_msgid_plural, dummy))
         {
-            msgid_plural = UnescapeCString(dummy.RemoveLast());
-            has_plural = true;
-            mlinenum = unsigned(m_textFile->GetCurrentLine() + 1);
-            while (!(line = ReadTextLine()).empty())
-            {
-                if (line[0u] == _T('\t'))
-                    line.Remove(0, 1);
-                if (line[0u] == _T('"') && line.Last() == _T('"'))
-                {
-                    msgid_plural += UnescapeCString(line.Mid(1, line.Length() - 2));
-                    PossibleWrappedLine();
-                }
-                else
-                    break;
-            }
+            entry.hasPlural = true;
+            entry.lineNumber = m_lineNumber;
+            entry.msgid_plural = ReadQuotedValue(dummy, line);
         }
 
         // msgstr:
         else if (ReadParam(line, prefix_msgstr, dummy))
         {
-            if (has_plural)
+            if (entry.hasPlural)
             {
-                wxLogError(_("Broken PO file: singular form msgstr used together with msgid_plural"));
+                m_error = _("Broken PO file: singular form msgstr used together with msgid_plural");
                 return false;
             }
 
-            wxString str = UnescapeCString(dummy.RemoveLast());
-            while (!(line = ReadTextLine()).empty())
-            {
-                if (line[0u] == _T('\t'))
-                    line.Remove(0, 1);
-                if (line[0u] == _T('"') && line.Last() == _T('"'))
-                {
-                    str += UnescapeCString(line.Mid(1, line.Length() - 2));
-                    PossibleWrappedLine();
-                }
-                else
-                    break;
-            }
-            mtranslations.Add(str);
+            entry.translations.push_back(ReadQuotedValue(dummy, line));
 
-            bool shouldIgnore = m_ignoreHeader && (mstr.empty() && !has_context);
+            bool shouldIgnore = m_ignoreHeader && (entry.msgid.empty() && !entry.hasContext);
             if ( shouldIgnore )
             {
                 OnIgnoredEntry();
             }
             else
             {
-                if (!mstr.empty() && m_ignoreTranslations)
-                    mtranslations.clear();
-
-                if (!OnEntry(mstr, wxEmptyString, false,
-                             has_context, msgctxt,
-                             mtranslations,
-                             mflags, mrefs, mcomment, mextractedcomments, msgid_old,
-                             mlinenum))
-                {
+                if (!entry.msgid.empty() && m_ignoreTranslations)
+                    entry.translations.clear();
+
+                finishEntry();
+                if (!OnEntry(entry))
                     return false;
-                }
             }
 
-            mcomment = mstr = msgid_plural = msgctxt = mflags = wxEmptyString;
-            has_plural = has_context = false;
-            mrefs.Clear();
-            mextractedcomments.Clear();
-            mtranslations.Clear();
-            msgid_old.Clear();
+            resetEntry();
         }
 
         // msgstr[i]:
         else if (ReadParam(line, prefix_msgstr_plural, dummy))
         {
-            if (!has_plural)
+            if (!entry.hasPlural)
             {
-                wxLogError(_("Broken PO file: plural form msgstr used without msgid_plural"));
+                m_error = _("Broken PO file: plural form msgstr used without msgid_plural");
                 return false;
             }
 
-            wxString idx = dummy.BeforeFirst(wxS(']'));
-            wxString label_prefix = prefix_msgstr_plural + idx + wxS("] \"");
+            auto makeLabel = [&label_prefix](std::string_view rest)
+            {
+                label_prefix.assign(prefix_msgstr_plural);
+                label_prefix.append(rest.substr(0, rest.find(']')));
+                label_prefix.append("] \"");
+            };
+            makeLabel(dummy);
 
             while (ReadParam(line, label_prefix, dummy))
             {
-                wxString str = UnescapeCString(dummy.RemoveLast());
-
-                while (!(line=ReadTextLine()).empty())
-                {
-                    line.Trim(/*fromRight=*/false);
-                    if (line[0u] == wxS('"') && line.Last() == wxS('"'))
-                    {
-                        str += UnescapeCString(line.Mid(1, line.Length() - 2));
-                        PossibleWrappedLine();
-                    }
-                    else
-                    {
-                        if (ReadParam(line, prefix_msgstr_plural, dummy))
-                        {
-                            idx = dummy.BeforeFirst(wxS(']'));
-                            label_prefix = prefix_msgstr_plural + idx + wxS("] \"");
-                        }
-                        break;
-                    }
-                }
-                mtranslations.Add(str);
+                entry.translations.push_back(ReadQuotedValue(dummy, line));
+                if (!line.empty() && ReadParam(line, prefix_msgstr_plural, dummy))
+                    makeLabel(dummy);
             }
 
             if (m_ignoreTranslations)
-                mtranslations.clear();
+                entry.translations.clear();
 
-            if (!OnEntry(mstr, msgid_plural, true,
-                         has_context, msgctxt,
-                         mtranslations,
-                         mflags, mrefs, mcomment, mextractedcomments, msgid_old,
-                         mlinenum))
-            {
+            finishEntry();
+            if (!OnEntry(entry))
                 return false;
-            }
 
-            mcomment = mstr = msgid_plural = msgctxt = mflags = wxEmptyString;
-            has_plural = has_context = false;
-            mrefs.Clear();
-            mextractedcomments.Clear();
-            mtranslations.Clear();
-            msgid_old.Clear();
+            resetEntry();
         }
 
         // deleted lines:
         else if (ReadParam(line, prefix_deleted, dummy))
         {
-            wxArrayString deletedLines;
-            deletedLines.Add(line);
-            mlinenum = unsigned(m_textFile->GetCurrentLine() + 1);
+            entry.deletedLines.push_back(line);
+            entry.lineNumber = m_lineNumber;
             while (!(line = ReadTextLine()).empty())
             {
                 // if line does not start with "#~" anymore, stop reading
@@ -453,36 +540,29 @@ bool POCatalogParser::Parse()
                 if (ReadParam(line, prefix_deleted_msgid, dummy))
                     break;
 
-                deletedLines.Add(line);
+                entry.deletedLines.push_back(line);
             }
 
             if (!m_ignoreTranslations)
             {
-                if (!OnDeletedEntry(deletedLines,
-                                    mflags, mrefs, mcomment, mextractedcomments, mlinenum))
-                {
+                finishEntry();
+                if (!OnDeletedEntry(entry))
                     return false;
-                }
             }
 
-            mcomment = mstr = msgid_plural = mflags = wxEmptyString;
-            has_plural = false;
-            mrefs.Clear();
-            mextractedcomments.Clear();
-            mtranslations.Clear();
-            msgid_old.Clear();
+            resetEntry();
         }
 
         // comment:
-        else if (line[0u] == wxS('#'))
+        else if (line[0] == '#')
         {
             bool readNewLine = false;
 
             while (!line.empty() &&
-                    line[0u] == wxS('#') &&
-                   (line.Length() < 2 || (line[1u] != wxS(',') && line[1u] != wxS(':') && line[1u] != wxS('.') && line[1u] != wxS('~') )))
+                    line[0] == '#' &&
+                   (line.length() < 2 || (line[1] != ',' && line[1] != ':' && line[1] != '.' && line[1] != '~' )))
             {
-                mcomment << line << wxS('\n');
+                comments.push_back(line);
                 readNewLine = true;
                 line = ReadTextLine();
             }
@@ -501,29 +581,49 @@ bool POCatalogParser::Parse()
 }
 
 
-wxString POCatalogParser::ReadTextLine()
+std::string_view POCatalogParser::ReadTextLine()
 {
     m_previousLineHardWrapped = m_lastLineHardWrapped;
     m_lastLineHardWrapped = false;
+    m_prevLineEnd = m_lineEnd;
 
-    static const wxString msgid_alone(wxS("msgid \"\""));
-    static const wxString msgstr_alone(wxS("msgstr \"\""));
+    static const std::string_view msgid_alone("msgid \"\"");
+    static const std::string_view msgstr_alone("msgstr \"\"");
 
-    for (;;)
+    const size_t len = m_data.size();
+    while (m_pos < len)
     {
-        if (m_textFile->Eof())
-            return wxString();
+        // find the next line and skip past its EOL:
+        size_t eol = m_pos;
+        while (eol < len && m_data[eol] != '\n' && m_data[eol] != '\r')
+            eol++;
+
+        const size_t start = m_pos;
+        std::string_view ln = m_data.substr(m_pos, eol - m_pos);
+        m_pos = eol;
+        if (m_pos < len)
+        {
+            if (m_data[m_pos] == '\r' && m_pos + 1 < len && m_data[m_pos + 1] == '\n')
+            {
+                m_eolCount[wxTextFileType_Dos]++;
+                m_pos += 2;
+            }
+            else
+            {
+                m_eolCount[m_data[m_pos] == '\n' ? wxTextFileType_Unix : wxTextFileType_Mac]++;
+                m_pos++;
+            }
+        }
+        m_lineNumber++;
 
-        // read next line and strip insignificant whitespace from it:
-        const auto& ln = m_textFile->GetNextLine();
         if (ln.empty())
             continue;
 
         // gettext tools don't include (extracted) comments in wrapping, so they can't
         // be reliably used to detect file's wrapping either; just skip them.
-        if (!ln.starts_with(wxS("#. ")) && !ln.starts_with(wxS("# ")))
+        if (!StartsWith(ln, "#. ") && !StartsWith(ln, "# "))
         {
-            if (ln.ends_with(wxS("\\n\"")))
+            if (EndsWith(ln, "\\n\""))
             {
                 // Similarly, lines ending with \n are always wrapped, so skip that too.
                 m_lastLineHardWrapped = true;
@@ -539,26 +639,29 @@ wxString POCatalogParser::ReadTextLine()
                 // That "2" is to account for unwrappable comment lines: "#: somethinglong"
                 // See https://github.com/vslavik/poedit/issues/135
                 auto space = ln.find_last_of(' ');
-                if (space != wxString::npos && space > 2)
+                if (space != std::string_view::npos && space > 2)
                 {
-                    m_detectedLineWidth = std::max(m_detectedLineWidth, (int)ln.size());
+                    // line width is measured in characters, not UTF-8 bytes:
+                    int width = (int)std::count_if(ln.begin(), ln.end(), [](char c){ return (c & 0xC0) != 0x80; });
+                    m_detectedLineWidth = std::max(m_detectedLineWidth, width);
                 }
             }
         }
 
-        if (wxIsspace(ln[0]) || wxIsspace(ln.Last()))
-        {
-            auto s = ln.Strip(wxString::both);
-            if (!s.empty())
-                return s;
-        }
-        else
+        // strip insignificant whitespace:
+        while (!ln.empty() && IsSpace(ln.front()))
+            ln.remove_prefix(1);
+        ln = TrimRight(ln);
+        if (!ln.empty())
         {
+            m_lineStart = start;
+            m_lineEnd = m_pos;
             return ln;
         }
     }
 
-    return wxString();
+    m_lineStart = len;
+    return std::string_view();
 }
 
 int POCatalogParser::GetWrappingWidth() const
@@ -569,39 +672,123 @@ int POCatalogParser::GetWrappingWidth() const
     return m_detectedLineWidth;
 }
 
+std::vector<std::string_view> POCatalogParser::SplitIntoChunks(std::string_view data, size_t maxChunks)
+{
+    // don't bother for small files, the overhead wouldn't pay off:
+    static const size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+    std::vector<std::string_view> chunks;
+    const size_t count = std::min(maxChunks, data.size() / MIN_CHUNK_SIZE);
+    if (count <= 1)
+    {
+        chunks.push_back(data);
+        return chunks;
+    }
+
+    // Is there an entry boundary (i.e. blank line) at pos, which points just past a newline?
+    auto isBoundary = [&data](size_t pos)
+    {
+        // previous line must end a complete entry, i.e. be a string or msgstr...
+        size_t prevEnd = pos - 1;
+        if (prevEnd == 0)
+            return false;
+        if (prevEnd > 0 && data[prevEnd - 1] == '\r')
+            prevEnd--;
+        size_t prevStart = data.rfind('\n', prevEnd - 1);
+        prevStart = (prevStart == std::string_view::npos) ? 0 : prevStart + 1;
+        auto prev = data.substr(prevStart, prevEnd - prevStart);
+        if (prev.empty() || !(prev.back() == '"' || StartsWith(prev, "#~")))
+            return false;
+
+        // ...followed by an empty line...
+        size_t next = pos;
+        if (next < data.size() && data[next] == '\r')
+            next++;
+        if (next >= data.size() || data[next] != '\n')
+            return false;
+        next++;
+
+        // ...and then start of a new entry:
+        auto rest = data.substr(next);
+        return StartsWith(rest, "#") || StartsWith(rest, "msgctxt ") || StartsWith(rest, "msgid ");
+    };
+
+    const size_t approxSize = data.size() / count;
+    size_t start = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        size_t pos = std::max(start, i * approxSize);
+        size_t split = std::string_view::npos;
+        while ((pos = data.find('\n', pos)) != std::string_view::npos)
+        {
+            pos++;
+            if (isBoundary(pos))
+            {
+                split = pos;
+                break;
+            }
+        }
+        if (split == std::string_view::npos)
+            break;
+
+        chunks.push_back(data.substr(start, split - start));
+        start = split;
+    }
+    chunks.push_back(data.substr(start));
+
+    return chunks;
+}
+
+void POCatalogParser::AccumulateFormatInfo(const POCatalogParser& next)
+{
+    m_detectedLineWidth = std::max(m_detectedLineWidth, next.m_detectedLineWidth);
+    m_detectedWrappedLines = m_detectedWrappedLines || next.m_detectedWrappedLines;
+    for (size_t i = 0; i < WXSIZEOF(m_eolCount); i++)
+        m_eolCount[i] += next.m_eolCount[i];
+    m_lineNumber += next.m_lineNumber;
+}
+
+wxTextFileType POCatalogParser::GetLineEndingsFormat() const
+{
+    const size_t nUnix = m_eolCount[wxTextFileType_Unix] + m_eolCount[wxTextFileType_Mac];
+    const size_t nDos = m_eolCount[wxTextFileType_Dos];
+
+    // Discard any unsupported setting. In particular, we ignore "Mac"
+    // line endings, because the ancient OS 9 systems aren't used anymore,
+    // OSX uses Unix ending *and* "Mac" endings break gettext tools. So if
+    // we encounter a catalog with "Mac" line endings, we silently convert
+    // it into Unix endings (i.e. the modern Mac).
+    if (nUnix == 0 && nDos == 0)
+        return wxTextFileType_None;
+    return nDos > nUnix ? wxTextFileType_Dos : wxTextFileType_Unix;
+}
+
 
 
 class POCharsetInfoFinder : public POCatalogParser
 {
     public:
-        POCharsetInfoFinder(wxTextFile *f)
-                : POCatalogParser(f), m_charset("UTF-8") {}
+        POCharsetInfoFinder(std::string_view data)
+                : POCatalogParser(data), m_charset("UTF-8"), m_found(false) {}
         wxString GetCharset() const { return m_charset; }
+        bool FoundHeader() const { return m_found; }
 
     protected:
         wxString m_charset;
+        bool m_found;
 
-        virtual bool OnEntry(const wxString& msgid,
-                             const wxString& /*msgid_plural*/,
-                             bool /*has_plural*/,
-                             bool has_context,
-                             const wxString& /*context*/,
-                             const wxArrayString& mtranslations,
-                             const wxString& /*flags*/,
-                             const wxArrayString& /*references*/,
-                             const wxString& /*comment*/,
-                             const wxArrayString& /*extractedComments*/,
-                             const wxArrayString& /*msgid_old*/,
-                             unsigned /*lineNumber*/)
-        {
-            if (msgid.empty() && !has_context)
+        bool OnEntry(const Entry& entry) override
+        {
+            if (entry.msgid.empty() && !entry.hasContext)
             {
-                // gettext header:
+                // gettext header (whose charset isn't known yet, but it's ASCII-compatible):
                 Catalog::HeaderData hdr;
-                hdr.FromString(mtranslations[0]);
+                auto& raw = entry.translations[0];
+                hdr.FromString(wxString(raw.data(), wxConvISO8859_1, raw.size()));
                 m_charset = hdr.Charset;
                 if (m_charset == "CHARSET")
                     m_charset = "ISO-8859-1";
+                m_found = true;
                 return false; // stop parsing
             }
             return true;
@@ -613,145 +800,138 @@ class POCharsetInfoFinder : public POCatalogParser
 class POLoadParser : public POCatalogParser
 {
     public:
-        POLoadParser(POCatalog& c, wxTextFile *f)
-              : POCatalogParser(f),
-                FileIsValid(false),
-                m_catalog(c), m_nextId(1), m_seenHeaderAlready(false) {}
+        POLoadParser(std::string_view data, StringPool& pool)
+              : POCatalogParser(data),
+                FileIsValid(false), HasHeader(false), HasPluralItems(false),
+                m_pool(pool),
+                m_deferredBuffer(std::make_shared<std::string>()) {}
 
         // true if the file is valid, i.e. has at least some data
         bool FileIsValid;
 
-        Language GetSpecifiedMsgidLanguage()
-        {
-            auto x_srclang = m_catalog.Header().GetHeader("X-Source-Language");
-            if (x_srclang.empty())
-                x_srclang = m_catalog.m_header.GetHeader("X-Loco-Source-Locale");
-            if (!x_srclang.empty())
-            {
-                auto parsed = Language::TryParse(str::to_utf8(x_srclang));
-                if (parsed.IsValid())
-                    return parsed;
-            }
-            return Language();
-        }
+        // Parsed data, to be moved into the catalog; item IDs are
+        // assigned and line numbers are relative to the parsed data
+        bool HasHeader;
+        wxString HeaderText, HeaderComment;
+        std::vector<POCatalogItemPtr> Items;
+        POCatalogDeletedDataArray DeletedItems;
+
+        // Raw text of the header and of Items in the parsed data
+        std::string_view HeaderSource;
+        std::vector<std::string_view> ItemSources;
+        bool HasPluralItems;
 
     protected:
-        POCatalog& m_catalog;
-
-        virtual bool OnEntry(const wxString& msgid,
-                             const wxString& msgid_plural,
-                             bool has_plural,
-                             bool has_context,
-                             const wxString& context,
-                             const wxArrayString& mtranslations,
-                             const wxString& flags,
-                             const wxArrayString& references,
-                             const wxString& comment,
-                             const wxArrayString& extractedComments,
-                             const wxArrayString& msgid_old,
-                             unsigned lineNumber);
-
-        virtual bool OnDeletedEntry(const wxArrayString& deletedLines,
-                                    const wxString& flags,
-                                    const wxArrayString& references,
-                                    const wxString& comment,
-                                    const wxArrayString& extractedComments,
-                                    unsigned lineNumber);
-
-        virtual void OnIgnoredEntry() { FileIsValid = true; }
+        bool OnEntry(const Entry& entry) override;
+        bool OnDeletedEntry(const Entry& entry) override;
+
+        void OnIgnoredEntry() override { FileIsValid = true; }
 
     private:
-        int m_nextId;
-        bool m_seenHeaderAlready;
+        StringPool& m_pool;
+        // raw lines of rarely used fields of all Items, see POCatalogItem::DeferredLines
+        std::shared_ptr<std::string> m_deferredBuffer;
 };
 
 
-bool POLoadParser::OnEntry(const wxString& msgid,
-                         const wxString& msgid_plural,
-                         bool has_plural,
-                         bool has_context,
-                         const wxString& context,
-                         const wxArrayString& mtranslations,
-                         const wxString& flags,
-                         const wxArrayString& references,
-                         const wxString& comment,
-                         const wxArrayString& extractedComments,
-                         const wxArrayString& msgid_old,
-                         unsigned lineNumber)
+bool POLoadParser::OnEntry(const Entry& entry)
 {
     FileIsValid = true;
 
-    static const wxString MSGCAT_CONFLICT_MARKER("#-#-#-#-#");
+    static const std::string_view MSGCAT_CONFLICT_MARKER("#-#-#-#-#");
 
-    if (msgid.empty() && !has_context)
+    if (entry.msgid.empty() && !entry.hasContext)
     {
-        if (!m_seenHeaderAlready)
+        if (!HasHeader)
         {
             // gettext header:
-            m_catalog.m_header.FromString(mtranslations[0]);
-            m_catalog.m_header.Comment = comment;
-            for (const auto& s : extractedComments)
-                m_catalog.m_header.Comment += "\n#. " + s;
-            for (const auto& s : references)
-                m_catalog.m_header.Comment += "\n#: " + s;
-            if (!flags.empty())
-                m_catalog.m_header.Comment += "\n#" + flags;
-            m_seenHeaderAlready = true;
+            HeaderText = FromUTF8View(entry.translations[0]);
+            HeaderComment = FromUTF8View(entry.comment);
+            for (const auto& s : entry.extractedComments)
+                HeaderComment += "\n#. " + FromUTF8View(s);
+            for (const auto& s : entry.references)
+                HeaderComment += "\n#: " + FromUTF8View(s);
+            if (!entry.flags.empty())
+                HeaderComment += "\n#" + FromUTF8View(entry.flags);
+            HeaderSource = entry.source;
+            HasHeader = true;
         }
         // else: ignore duplicate header in malformed files
     }
     else
     {
         auto d = std::make_shared<POCatalogItem>();
-        d->SetId(m_nextId++);
-        if (!flags.empty())
-            d->SetFlags(flags);
-        d->SetString(msgid);
-        if (has_plural)
+        if (!entry.flags.empty())
+            d->SetFlags(FromUTF8View(entry.flags));
+        d->SetString(FromUTF8View(entry.msgid));
+        if (entry.hasPlural)
         {
-            m_catalog.m_hasPluralItems = true;
-            d->SetPluralString(msgid_plural);
+            HasPluralItems = true;
+            d->SetPluralString(FromUTF8View(entry.msgid_plural));
         }
-        if (has_context)
-            d->SetContext(context);
-        d->SetTranslations(mtranslations);
-        d->SetComment(comment);
-        d->SetLineNumber(lineNumber);
-        d->SetRawReferences(references);
-
-        for (auto i: extractedComments)
+        if (entry.hasContext)
+            d->SetContext(FromUTF8View(entry.context));
+        d->SetTranslations(FromUTF8Views(entry.translations));
+        d->SetComment(FromUTF8View(entry.comment));
+        d->SetLineNumber(entry.lineNumber);
+        d->InternData(m_pool);
+
+        // References, extracted comments and old msgids aren't needed for most
+        // items, so only their raw lines are kept until they are first used:
+        POCatalogItem::DeferredLines lines;
+        auto& buffer = *m_deferredBuffer;
+        lines.offset = buffer.size();
+        auto appendLine = [&buffer](std::string_view line)
+        {
+            buffer.append(line);
+            buffer += '\n';
+        };
+        for (auto& i: entry.references)
+        {
+            appendLine(i);
+            lines.references++;
+        }
+        for (auto& i: entry.extractedComments)
         {
             // Sometimes, msgcat produces conflicts in extracted comments; see the gory details:
             // https://groups.google.com/d/topic/poedit/j41KuvXtVUU/discussion
             // As a workaround, just filter them out.
             // FIXME: Fix this properly... but not using msgcat in the first place
-            if (i.starts_with(MSGCAT_CONFLICT_MARKER) && i.ends_with(MSGCAT_CONFLICT_MARKER))
+            if (StartsWith(i, MSGCAT_CONFLICT_MARKER) && EndsWith(i, MSGCAT_CONFLICT_MARKER))
                 continue;
-            d->AddExtractedComments(i);
+            appendLine(i);
+            lines.extractedComments++;
+        }
+        for (auto& i: entry.msgidOld)
+        {
+            appendLine(i);
+            lines.oldMsgid++;
         }
-        d->SetOldMsgid(msgid_old);
-        m_catalog.AddItem(d);
+        lines.length = buffer.size() - lines.offset;
+        if (lines.length)
+        {
+            lines.buffer = m_deferredBuffer;
+            d->SetDeferredLines(std::move(lines));
+        }
+
+        Items.push_back(d);
+        ItemSources.push_back(entry.source);
     }
     return true;
 }
 
-bool POLoadParser::OnDeletedEntry(const wxArrayString& deletedLines,
-                                const wxString& flags,
-                                const wxArrayString& /*references*/,
-                                const wxString& comment,
-                                const wxArrayString& extractedComments,
-                                unsigned lineNumber)
+bool POLoadParser::OnDeletedEntry(const Entry& entry)
 {
     FileIsValid = true;
 
     POCatalogDeletedData d;
-    if (!flags.empty()) d.SetFlags(flags);
-    d.SetDeletedLines(deletedLines);
-    d.SetComment(comment);
-    d.SetLineNumber(lineNumber);
-    for (size_t i = 0; i < extractedComments.GetCount(); i++)
-      d.AddExtractedComments(extractedComments[i]);
-    m_catalog.AddDeletedItem(d);
+    if (!entry.flags.empty()) d.SetFlags(FromUTF8View(entry.flags));
+    d.SetDeletedLines(FromUTF8Views(entry.deletedLines));
+    d.SetComment(FromUTF8View(entry.comment));
+    d.SetLineNumber(entry.lineNumber);
+    for (auto& i: entry.extractedComments)
+      d.AddExtractedComments(FromUTF8View(i));
+    DeletedItems.push_back(d);
 
     return true;
 }
@@ -770,7 +950,8 @@ wxArrayString POCatalogItem::GetReferences() const
     // characters U+2068 and U+2069.
     wxArrayString refs;
 
-    for (auto ref = m_references.begin(); ref != m_references.end(); ++ref)
+    auto& references = GetRawReferences();
+    for (auto ref = references.begin(); ref != references.end(); ++ref)
     {
         auto line = ref->Strip(wxString::both);
         wxString buf;
@@ -816,6 +997,46 @@ wxArrayString POCatalogItem::GetReferences() const
 }
 
 
+void POCatalogItem::InternData(StringPool& pool)
+{
+    CatalogItem::InternData(pool);
+    if (m_references)
+        m_references = pool.Intern(*m_references);
+}
+
+
+void POCatalogItem::SetDeferredLines(DeferredLines&& lines)
+{
+    m_deferredLines = std::move(lines);
+    SetHasDeferredData();
+}
+
+
+void POCatalogItem::LoadDeferredData()
+{
+    auto data = std::string_view(*m_deferredLines.buffer).substr(m_deferredLines.offset, m_deferredLines.length);
+    auto readLines = [&data](uint32_t count)
+    {
+        wxArrayString lines;
+        lines.reserve(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto eol = data.find('\n');
+            lines.push_back(FromUTF8View(data.substr(0, eol)));
+            data.remove_prefix(eol + 1);
+        }
+        return StringPool::Wrap(lines);
+    };
+
+    m_references = readLines(m_deferredLines.references);
+    m_extractedComments = readLines(m_deferredLines.extractedComments);
+    m_oldMsgid = readLines(m_deferredLines.oldMsgid);
+
+    // release the reference to the shared buffer:
+    m_deferredLines = DeferredLines();
+}
+
+
 // ----------------------------------------------------------------------
 // POCatalog class
 // ----------------------------------------------------------------------
@@ -882,79 +1103,385 @@ wxString POCatalog::GetPreferredExtension() const
 }
 
 
-static inline wxString GetCurrentTimeString()
+/**
+    UTF-8 encoded content of a PO file, ready for POCatalogParser.
+
+    The file is read (memory-mapped) only once: its charset is sniffed from
+    raw header bytes and UTF-8 files, by far the most common case, are then
+    parsed directly from the mapped memory after validation. Files in other
+    charsets are converted to UTF-8 in a single pass.
+ */
+class POFileContent
 {
-    return wxDateTime::Now().Format("%Y-%m-%d %H:%M%z");
-}
+public:
+    explicit POFileContent(const wxString& filename) : m_filename(filename), m_file(filename)
+    {
+        if (!m_file.IsOk())
+            return;
 
+        auto data = m_file.view();
 
-void POCatalog::Load(const wxString& po_file, int flags)
-{
-    wxTextFile f;
+        // skip UTF-8 BOM, if present:
+        if (StartsWith(data, "\xEF\xBB\xBF"))
+            data.remove_prefix(3);
 
-    Clear();
-    m_fileName = po_file;
-    m_header.BasePath = wxEmptyString;
+        m_charset = SniffCharset(data);
 
-    wxString ext;
-    wxFileName::SplitPath(po_file, nullptr, nullptr, &ext);
-    if (ext.CmpNoCase("pot") == 0 || (flags & CreationFlag_IgnoreTranslations))
-        m_fileType = Type::POT;
-    else
-        m_fileType = Type::PO;
+        if (IsUTF8(m_charset))
+            DecodeUTF8(data);
+        else
+            DecodeWithConv(data);
+    }
 
-    /* Load the .po file: */
+    bool IsOk() const { return m_file.IsOk(); }
+
+    /// Charset of the file, as declared in its header
+    const wxString& GetCharset() const { return m_charset; }
+
+    /// Were all lines decoded correctly?
+    bool HasDecodingErrors() const { return m_decodingErrors; }
+
+    /// UTF-8 content of the file
+    std::string_view view() const { return m_content; }
 
-    if (!f.Open(po_file, wxConvISO8859_1))
+    /// Raw content of the file, as stored on disk
+    std::string_view raw() const { return m_file.view(); }
+
+    /// Is view() part of raw(), i.e. the file didn't need any conversion?
+    bool IsRaw() const
     {
-        BOOST_THROW_EXCEPTION(Exception(_(L"Couldn’t load the file, it is probably damaged.")));
+        auto r = raw();
+        return m_content.data() >= r.data() && m_content.data() + m_content.size() <= r.data() + r.size();
     }
 
+private:
+    static bool IsUTF8(const wxString& charset)
     {
-        wxLogNull null; // don't report parsing errors from here, report them later
-        POCharsetInfoFinder charsetFinder(&f);
-        charsetFinder.Parse();
-        m_header.Charset = charsetFinder.GetCharset();
+        return charset.CmpNoCase("UTF-8") == 0 || charset.CmpNoCase("UTF8") == 0;
     }
 
-    f.Close();
-    wxCSConv encConv(m_header.Charset);
-    if (!f.Open(po_file, encConv))
+    /// Calls callback for each line in the data, passing it the line's content including EOL.
+    template<typename F>
+    static void ForEachLine(std::string_view data, F&& callback)
     {
-        BOOST_THROW_EXCEPTION(Exception(_(L"Couldn’t load the file, it is probably damaged.")));
+        size_t pos = 0;
+        while (pos < data.size())
+        {
+            auto eol = data.find('\n', pos);
+            eol = (eol == std::string_view::npos) ? data.size() : eol + 1;
+            callback(data.substr(pos, eol - pos));
+            pos = eol;
+        }
     }
 
-    if (!VerifyFileCharset(f, po_file, m_header.Charset))
+    static bool IsValidUTF8(std::string_view s)
     {
-        wxLogError(_("There were errors when loading the file. Some data may be missing or corrupted as the result."));
+        auto p = reinterpret_cast<const unsigned char*>(s.data());
+        auto end = p + s.size();
+        while (p < end)
+        {
+            const unsigned char c = *p;
+            if (c < 0x80)
+            {
+                p++;
+                continue;
+            }
+
+            int len;
+            uint32_t cp;
+            if ((c & 0xE0) == 0xC0)      { len = 2; cp = c & 0x1F; }
+            else if ((c & 0xF0) == 0xE0) { len = 3; cp = c & 0x0F; }
+            else if ((c & 0xF8) == 0xF0) { len = 4; cp = c & 0x07; }
+            else return false;
+
+            if (end - p < len)
+                return false;
+            for (int i = 1; i < len; i++)
+            {
+                if ((p[i] & 0xC0) != 0x80)
+                    return false;
+                cp = (cp << 6) | (p[i] & 0x3F);
+            }
+
+            // reject overlong forms, surrogates and out-of-range values:
+            static const uint32_t minValue[] = { 0, 0, 0x80, 0x800, 0x10000 };
+            if (cp < minValue[len] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+                return false;
+
+            p += len;
+        }
+        return true;
+    }
+
+    /// Determines file's charset from the header, looking at raw bytes only.
+    static wxString SniffCharset(std::string_view data)
+    {
+        // The header is virtually always the first entry, so only the lines up to
+        // the end of the first entry need to be examined. All charsets permitted in
+        // PO files are ASCII-compatible, so the parser can handle them as bytes.
+        auto header = data;
+        auto pos = data.find("msgstr");
+        if (pos != std::string_view::npos)
+        {
+            auto end = data.find("\n\n", pos);
+            if (end == std::string_view::npos)
+                end = data.find("\r\n\r\n", pos);
+            if (end != std::string_view::npos)
+                header = data.substr(0, end + 1);
+        }
+
+        auto charset = SniffCharsetIn(header);
+        if (!charset && header.size() < data.size())
+            charset = SniffCharsetIn(data);  // unusual file with header not at the top
+
+        return charset ? *charset : wxString("UTF-8");
+    }
+
+    static std::optional<wxString> SniffCharsetIn(std::string_view data)
+    {
+        wxLogNull null; // don't report parsing errors from here, report them later
+        POCharsetInfoFinder charsetFinder(data);
+        charsetFinder.Parse();
+        if (!charsetFinder.FoundHeader())
+            return std::nullopt;
+        return charsetFinder.GetCharset();
+    }
+
+    void DecodeUTF8(std::string_view data)
+    {
+        if (IsValidUTF8(data))
+        {
+            m_content = data;  // fast path: use the file's memory directly
+            return;
+        }
+
+        // Copy valid lines, blank out invalid ones:
+        m_converted.reserve(data.size());
+        size_t lineno = 0;
+        ForEachLine(data, [&](std::string_view line)
+        {
+            if (IsValidUTF8(line))
+            {
+                m_converted.append(line);
+            }
+            else
+            {
+                ReportCorruptedLine(lineno);
+                m_converted.push_back('\n');
+            }
+            lineno++;
+        });
+        m_content = m_converted;
     }
 
-    POLoadParser parser(*this, &f);
-    parser.IgnoreHeader(flags & CreationFlag_IgnoreHeader);
-    parser.IgnoreTranslations(flags & CreationFlag_IgnoreTranslations);
-    if (!parser.Parse())
+    void DecodeWithConv(std::string_view data)
+    {
+        wxCSConv conv(m_charset);
+
+        // Most files convert cleanly, so try to do it in one go first:
+        wxString all(data.data(), conv, data.size());
+        if (!all.empty() || data.empty())
+        {
+            m_converted = all.utf8_string();
+            m_content = m_converted;
+            return;
+        }
+
+        // ...and only if that fails, convert line by line to find the culprits:
+        size_t lineno = 0;
+        ForEachLine(data, [&](std::string_view line)
+        {
+            wxString str(line.data(), conv, line.size());
+            if (str.empty() && !line.empty())
+            {
+                ReportCorruptedLine(lineno);
+                m_converted.push_back('\n');
+            }
+            else
+            {
+                m_converted.append(str.utf8_string());
+            }
+            lineno++;
+        });
+        m_content = m_converted;
+    }
+
+    void ReportCorruptedLine(size_t lineno)
+    {
+        wxLogError(_(L"Line %d of file “%s” is corrupted (not valid %s data)."),
+                   int(lineno), m_filename.c_str(), m_charset.c_str());
+        m_decodingErrors = true;
+    }
+
+private:
+    wxString m_filename;
+    MappedFile m_file;
+    std::string m_converted;
+    std::string_view m_content;
+    wxString m_charset;
+    bool m_decodingErrors = false;
+};
+
+
+static inline wxString GetCurrentTimeString()
+{
+    return wxDateTime::Now().Format("%Y-%m-%d %H:%M%z");
+}
+
+
+void POCatalog::Load(const wxString& po_file, int flags)
+{
+
+    Clear();
+    m_fileName = po_file;
+    m_header.BasePath = wxEmptyString;
+
+    wxString ext;
+    wxFileName::SplitPath(po_file, nullptr, nullptr, &ext);
+    if (ext.CmpNoCase("pot") == 0 || (flags & CreationFlag_IgnoreTranslations))
+        m_fileType = Type::POT;
+    else
+        m_fileType = Type::PO;
+
+    /* Load the .po file: */
+
+    POFileContent f(po_file);
+    if (!f.IsOk())
     {
         BOOST_THROW_EXCEPTION(Exception(_(L"Couldn’t load the file, it is probably damaged.")));
     }
 
-    m_sourceLanguage = parser.GetSpecifiedMsgidLanguage();  // may be, and likely will, invalid
+    m_header.Charset = f.GetCharset();
+
+    if (f.HasDecodingErrors())
+    {
+        wxLogError(_("There were errors when loading the file. Some data may be missing or corrupted as the result."));
+    }
 
-    m_fileCRLF = GetFileCRLFFormat(f);
+    // Large files are split into chunks at entry boundaries and parsed in parallel:
+    auto chunks = POCatalogParser::SplitIntoChunks(f.view(), std::max(std::thread::hardware_concurrency(), 1u));
+
+    // Values repeated across entries are shared by all items parsed from the file:
+    StringPool pool;
+
+    std::vector<std::unique_ptr<POLoadParser>> parsers;
+    for (auto& chunk: chunks)
+    {
+        parsers.emplace_back(new POLoadParser(chunk, pool));
+        parsers.back()->IgnoreHeader(flags & CreationFlag_IgnoreHeader);
+        parsers.back()->IgnoreTranslations(flags & CreationFlag_IgnoreTranslations);
+    }
+
+    // Hash the content for CatalogCache while parsing, instead of reading the file again later:
+    dispatch::future<uint64_t> contentHash;
+    if (flags == 0 && CatalogCache::IsWorthCaching(f.raw().size()))
+        contentHash = dispatch::async([raw = f.raw()]{ return CatalogCache::HashContent(raw); });
+
+    std::atomic<bool> parsedOk(true);
+    dispatch::parallel_for(parsers.size(), [&](size_t i)
+    {
+        if (!parsers[i]->Parse())
+            parsedOk = false;
+    });
+
+    if (contentHash.valid())
+        m_loadedContentHash = contentHash.get();
+    if (!parsedOk)
+    {
+        // parsers run on worker threads, so their errors are logged from here:
+        for (auto& p: parsers)
+        {
+            if (!p->GetError().empty())
+                wxLogError("%s", p->GetError());
+        }
+        BOOST_THROW_EXCEPTION(Exception(_(L"Couldn’t load the file, it is probably damaged.")));
+    }
+
+    // Remember where the entries are if the file can be saved incrementally,
+    // i.e. if they are in the file verbatim and the header is used as-is:
+    std::unique_ptr<FileLayout> layout;
+    if (f.IsRaw() && !(flags & (CreationFlag_IgnoreHeader | CreationFlag_IgnoreTranslations)))
+        layout.reset(new FileLayout);
+    auto spanOf = [base = f.raw().data()](std::string_view source)
+    {
+        FileLayout::Span span;
+        span.offset = source.data() - base;
+        span.length = source.size();
+        return span;
+    };
+
+    // Stitch the results together, in order:
+    auto& parser = *parsers.front();
+    bool fileIsValid = false;
+    bool seenHeader = false;
+    int nextId = 1;
+    unsigned lineOffset = 0;
+    for (auto& p: parsers)
+    {
+        fileIsValid = fileIsValid || p->FileIsValid;
+
+        if (p->HasHeader && !seenHeader)
+        {
+            m_header.FromString(p->HeaderText);
+            m_header.Comment = p->HeaderComment;
+            seenHeader = true;
+            if (layout)
+                layout->header = spanOf(p->HeaderSource);
+        }
+
+        if (p->HasPluralItems)
+            m_hasPluralItems = true;
+
+        m_items.reserve(m_items.size() + p->Items.size());
+        for (auto& item: p->Items)
+        {
+            item->SetId(nextId++);
+            item->SetLineNumber(item->GetLineNumber() + lineOffset);
+            item->ClearDirty();
+            AddItem(item);
+        }
+        if (layout)
+        {
+            for (auto& source: p->ItemSources)
+                layout->items.push_back(spanOf(source));
+        }
+        for (auto& d: p->DeletedItems)
+        {
+            d.SetLineNumber(d.GetLineNumber() + lineOffset);
+            AddDeletedItem(d);
+        }
+
+        if (p.get() != &parser)
+            parser.AccumulateFormatInfo(*p);
+        lineOffset = parser.GetLinesCount();
+    }
+
+    m_sourceLanguage = GetSpecifiedMsgidLanguage(m_header);  // may be, and likely will, invalid
+
+    m_fileCRLF = parser.GetLineEndingsFormat();
     m_fileWrappingWidth = parser.GetWrappingWidth();
     wxLogTrace("poedit", "detect line wrapping: %d", m_fileWrappingWidth);
 
     // If we didn't find any entries, the file must be invalid:
-    if (!parser.FileIsValid)
+    if (!fileIsValid)
     {
         BOOST_THROW_EXCEPTION(Exception(_(L"Couldn’t load the file, it is probably damaged.")));
     }
 
-    f.Close();
-
     FixupCommonIssues();
 
     if ( flags & CreationFlag_IgnoreHeader )
         CreateNewHeader();
+
+    // the header must precede all items for incremental saving to work:
+    if (layout && layout->IsOk() &&
+        (layout->items.empty() || layout->header.offset + layout->header.length <= layout->items.front().offset))
+    {
+        layout->crlf = m_fileCRLF;
+        layout->wrapping = m_fileWrappingWidth;
+        layout->pluralsCount = std::max(GetPluralFormsCountPresentInItems(), GetPluralForms().nplurals());
+        SetFileLayout(po_file, std::move(layout));
+    }
 }
 
 
@@ -975,7 +1502,10 @@ void POCatalog::FixupCommonIssues()
             if (s.Contains(wxS("% ")) && !s.Contains(wxS("%% ")))
             {
                 auto poi = std::dynamic_pointer_cast<POCatalogItem>(i);
-                poi->m_moreFlags.Replace("php-format", "no-php-format");
+                wxString flags(*poi->m_moreFlags);
+                flags.Replace("php-format", "no-php-format");
+                poi->m_moreFlags = StringPool::Wrap(flags);
+                poi->m_isDirty = true;
             }
         }
     }
@@ -1027,9 +1557,11 @@ void POCatalog::Clear()
 {
     // Catalog base class fields:
     m_items.clear();
+    MarkItemsChanged();
 
     // PO-specific fields:
     m_deletedItems.clear();
+    m_fileLayout.reset();
 }
 
 
@@ -1037,81 +1569,516 @@ void POCatalog::Clear()
 namespace
 {
 
-inline bool CanEncodeStringToCharset(const wxString& s, wxMBConv& conv)
+// Default line width used by gettext tools
+const int DEFAULT_PAGE_WIDTH = 79;
+
+/// Returns the number of columns the character occupies on a terminal.
+inline int CharDisplayWidth(UChar32 c)
 {
-    if (s.empty())
-        return true;
-    const wxCharBuffer converted(s.mb_str(conv));
-    if ( converted.length() == 0 )
-        return false;
-    return true;
+    if (c < 0x80)
+        return 1;
+
+    switch (u_charType(c))
+    {
+        case U_NON_SPACING_MARK:
+        case U_ENCLOSING_MARK:
+        case U_FORMAT_CHAR:
+            return 0;
+        default:
+            break;
+    }
+
+    switch (u_getIntPropertyValue(c, UCHAR_EAST_ASIAN_WIDTH))
+    {
+        case U_EA_WIDE:
+        case U_EA_FULLWIDTH:
+            return 2;
+        default:
+            return 1;
+    }
 }
 
-bool CanEncodeToCharset(const wxTextBuffer& f, const wxString& charset)
+/**
+    Finds format directives in @a s, interpreted as @a format string (e.g.
+    "c"), and marks all their bytes except the first one in @a inside.
+
+    gettext doesn't wrap lines inside directives of strings with a *-format
+    flag. Only formats Poedit can parse are recognized; invalid directives
+    aren't marked, same as in gettext.
+ */
+void MarkFormatDirectives(const std::string& format, std::string_view s, std::vector<char>& inside)
 {
-    if (charset.Lower() == "utf-8" || charset.Lower() == "utf8")
-        return true;
+    inside.assign(s.size(), false);
 
-    wxCSConv conv(charset);
+    const bool isC = format == "c" || format == "objc";
+    const bool isPython = format == "python";
+    if (!isC && !isPython)
+        return;
 
-    const size_t lines = f.GetLineCount();
-    for ( size_t i = 0; i < lines; i++ )
+    const size_t len = s.size();
+    auto isOneOf = [&](size_t i, const char *chars)
     {
-        if ( !CanEncodeStringToCharset(f.GetLine(i), conv) )
-            return false;
+        return i < len && s[i] != '\0' && strchr(chars, s[i]) != nullptr;
+    };
+    auto skipDigits = [&](size_t i)
+    {
+        while (isOneOf(i, "0123456789"))
+            i++;
+        return i;
+    };
+    // C's "N$" argument number, if present
+    auto skipArgNumber = [&](size_t i)
+    {
+        size_t end = skipDigits(i);
+        return (end > i && end < len && s[end] == '$') ? end + 1 : i;
+    };
+
+    for (size_t start = 0; start < len; start++)
+    {
+        if (s[start] != '%')
+            continue;
+
+        size_t i = start + 1;
+        bool complete = false;
+
+        if (i < len && s[i] == '%')
+        {
+            complete = true;
+        }
+        else
+        {
+            if (isC)
+            {
+                i = skipArgNumber(i);
+            }
+            else if (i < len && s[i] == '(')
+            {
+                auto close = s.find(')', i);
+                if (close == std::string_view::npos)
+                    continue;
+                i = close + 1;
+            }
+
+            while (isOneOf(i, isC ? "-+ #0'I" : "-+ #0"))
+                i++;
+
+            // width and precision:
+            if (i < len && s[i] == '*')
+                i = isC ? skipArgNumber(i + 1) : i + 1;
+            else
+                i = skipDigits(i);
+            if (i < len && s[i] == '.')
+            {
+                i++;
+                if (i < len && s[i] == '*')
+                    i = isC ? skipArgNumber(i + 1) : i + 1;
+                else
+                    i = skipDigits(i);
+            }
+
+            // size:
+            while (isOneOf(i, isC ? "hlLqjzZt" : "hlL"))
+                i++;
+
+            if (isC && i < len && s[i] == '<')
+            {
+                // <inttypes.h> macro, e.g. %<PRId64>, includes the conversion
+                auto close = s.find('>', i);
+                if (close == std::string_view::npos)
+                    continue;
+                i = close;
+                complete = true;
+            }
+            else
+            {
+                const char *conversions = isPython ? "diouxXeEfFgGcrsa"
+                                        : format == "objc" ? "diouxXeEfFgGaAcsCSpn@"
+                                        : "diouxXeEfFgGaAcsCSpn";
+                complete = isOneOf(i, conversions);
+            }
+        }
+
+        if (!complete)
+            continue;
+
+        std::fill(inside.begin() + start + 1, inside.begin() + i + 1, true);
+        start = i;
     }
+}
 
-    return true;
+/**
+    Serializes PO data into UTF-8 text.
+
+    The output is formatted the same way as gettext tools (e.g. msgcat) format
+    it, so that saving a file produced by them doesn't generate spurious
+    changes: strings are split into separate lines after each \n and wrapped
+    at the configured width, references are re-flowed, everything else is
+    written verbatim.
+
+    Output is collected in a buffer. If a stream is given, the buffer is
+    written into it on Flush(), so that whole files don't need to be kept
+    in memory.
+ */
+class POWriter
+{
+public:
+    /**
+        Ctor.
+
+        @param crlf      Line endings to use.
+        @param wrapping  Maximum line width or POCatalog::NO_WRAPPING.
+        @param stream    Stream to write the output into, if any.
+     */
+    POWriter(wxTextFileType crlf, int wrapping, std::ostream *stream = nullptr)
+        : m_eol(crlf == wxTextFileType_Dos ? "\r\n" : "\n"),
+          m_pageWidth(wrapping > 0 ? wrapping : DEFAULT_PAGE_WIDTH),
+          m_wrapStrings(wrapping != POCatalog::NO_WRAPPING),
+          m_lineCount(0),
+          m_stream(stream),
+          m_flushed(0),
+          m_breaker(UBRK_LINE, Language())
+    {}
+
+    /// Offset of the next written byte in the output
+    size_t Offset() const { return m_flushed + m_out.size(); }
+
+    /// Writes buffered output into the stream. Returns false on I/O error.
+    bool Flush()
+    {
+        if (m_stream && !m_out.empty())
+        {
+            m_stream->write(m_out.data(), m_out.size());
+            m_flushed += m_out.size();
+            m_out.clear();
+        }
+        return !m_stream || m_stream->good();
+    }
+
+    /// Number of the line that will be written next (1-based)
+    int NextLineNumber() const { return m_lineCount + 1; }
+
+    /// Writes a line of text, terminated with EOL
+    void Line(std::string_view text = std::string_view())
+    {
+        m_out.append(text);
+        m_out.append(m_eol);
+        m_lineCount++;
+    }
+
+    void Line(std::string_view prefix, const wxString& text)
+    {
+        const auto utf8 = text.utf8_str();
+        m_out.append(prefix);
+        Line(std::string_view(utf8.data(), utf8.length()));
+    }
+
+    /// Appends already formatted text
+    void Verbatim(std::string_view text)
+    {
+        m_lineCount += (int)std::count(text.begin(), text.end(), '\n');
+        if (m_stream)
+        {
+            // copied text can be large, so don't buffer it
+            Flush();
+            m_stream->write(text.data(), text.size());
+            m_flushed += text.size();
+        }
+        else
+        {
+            m_out.append(text);
+        }
+    }
+
+    /// Writes multi-line text (e.g. comments), one line per '\n'-terminated part
+    void Lines(const wxString& text)
+    {
+        const auto utf8 = text.utf8_str();
+        std::string_view s(utf8.data(), utf8.length());
+        while (!s.empty())
+        {
+            auto eol = s.find('\n');
+            Line(s.substr(0, eol));
+            s.remove_prefix(eol == std::string_view::npos ? s.size() : eol + 1);
+        }
+    }
+
+    /// Writes "#:" lines, re-flowing the references the way gettext does
+    void References(const wxArrayString& rawRefs);
+
+    /**
+        Writes keyword followed by escaped, wrapped C string @a value.
+
+        If @a format is given (e.g. "c" for c-format), lines aren't broken
+        inside the value's format directives.
+     */
+    void String(std::string_view keyword, const wxString& value, const std::string& format = std::string())
+    {
+        const auto utf8 = value.utf8_str();
+        String(keyword, std::string_view(utf8.data(), utf8.length()), format);
+    }
+
+    void String(std::string_view keyword, std::string_view value, const std::string& format = std::string());
+
+    /// Returns lines written so far (without EOLs) and clears the buffer
+    wxArrayString TakeLines()
+    {
+        wxArrayString lines;
+        const std::string_view eolMarker(m_eol);
+        std::string_view s(m_out);
+        while (!s.empty())
+        {
+            auto eol = s.find(eolMarker);
+            lines.push_back(FromUTF8View(s.substr(0, eol)));
+            s.remove_prefix(eol == std::string_view::npos ? s.size() : eol + eolMarker.size());
+        }
+        m_out.clear();
+        return lines;
+    }
+
+private:
+    // Escapes a '\n'-delimited portion of string value into m_portion;
+    // inDirective marks its bytes that lines can't be broken before, if any
+    void EscapePortion(std::string_view portion, const char *inDirective);
+
+    // Computes line break positions in m_portion, stored in m_breaks
+    void ComputeBreaks(int startColumn, int width);
+
+private:
+    const char *m_eol;
+    int m_pageWidth;
+    bool m_wrapStrings;
+    int m_lineCount;
+
+    std::string m_out;
+    std::ostream *m_stream;
+    size_t m_flushed;
+
+    // scratch buffers reused between calls
+    std::string m_portion;
+    std::vector<char> m_noBreakBefore;
+    std::vector<char> m_inDirective;
+    std::vector<size_t> m_breaks;
+    unicode::BreakIterator m_breaker;
+};
+
+
+void POWriter::EscapePortion(std::string_view portion, const char *inDirective)
+{
+    m_portion.clear();
+    m_noBreakBefore.clear();
+
+    for (size_t i = 0; i < portion.size(); i++)
+    {
+        const char c = portion[i];
+        const bool noBreak = inDirective && inDirective[i];
+        char escaped = 0;
+        switch (c)
+        {
+            case '\a': escaped = 'a'; break;
+            case '\b': escaped = 'b'; break;
+            case '\f': escaped = 'f'; break;
+            case '\n': escaped = 'n'; break;
+            case '\r': escaped = 'r'; break;
+            case '\t': escaped = 't'; break;
+            case '\v': escaped = 'v'; break;
+            case '\\': escaped = '\\'; break;
+            case '"':  escaped = '"'; break;
+            default:
+                break;
+        }
+
+        if (escaped)
+        {
+            m_portion += '\\';
+            m_portion += escaped;
+            m_noBreakBefore.push_back(noBreak);
+            m_noBreakBefore.push_back(true);  // never split escape sequences
+        }
+        else
+        {
+            m_portion += c;
+            m_noBreakBefore.push_back(noBreak);
+        }
+    }
+
+    // like gettext, don't break immediately before the trailing "\n"
+    if (!portion.empty() && portion.back() == '\n')
+        m_noBreakBefore[m_portion.size() - 2] = true;
 }
 
-template<typename Func>
-inline void SplitIntoLines(const wxString& text, Func&& f)
+
+void POWriter::ComputeBreaks(int startColumn, int width)
 {
-    if (text.empty())
+    m_breaks.clear();
+
+    const char *data = m_portion.data();
+    const int32_t length = (int32_t)m_portion.size();
+
+    // Fast path: no need to look for break opportunities if everything fits
+    int total = startColumn;
+    for (int32_t i = 0; i < length && total <= width; )
+    {
+        UChar32 c;
+        U8_NEXT(data, i, length, c);
+        total += CharDisplayWidth(c);
+    }
+    if (total <= width)
         return;
 
-    wxString::const_iterator last = text.begin();
-    for (wxString::const_iterator i = text.begin(); i != text.end(); ++i)
+    // This is the same greedy algorithm gettext uses (via gnulib's
+    // ulc_width_linebreaks()), but with break opportunities provided by ICU:
+    m_breaker.set_text(std::string_view(m_portion));
+
+    int lastColumn = startColumn;
+    int pieceWidth = 0;
+    int32_t lastBreak = -1;
+
+    int32_t nextBoundary = m_breaker.begin();
+    for (int32_t i = 0; i < length; )
     {
-        if (*i == '\n')
+        while (nextBoundary != m_breaker.end() && nextBoundary < i)
+            nextBoundary = m_breaker.next();
+
+        if (i > 0 && nextBoundary == i && !m_noBreakBefore[i])
         {
-            f(wxString(last, i), false);
-            last = i + 1;
+            // an atomic piece of text ends here
+            if (lastBreak != -1 && lastColumn + pieceWidth > width)
+            {
+                m_breaks.push_back(lastBreak);
+                lastColumn = 0;
+            }
+            lastBreak = i;
+            lastColumn += pieceWidth;
+            pieceWidth = 0;
         }
+
+        UChar32 c;
+        U8_NEXT(data, i, length, c);
+        pieceWidth += CharDisplayWidth(c);
     }
 
-    if (last != text.end())
-        f(wxString(last, text.end()), true);
+    if (lastBreak != -1 && lastColumn + pieceWidth > width)
+        m_breaks.push_back(lastBreak);
 }
 
-void SaveMultiLines(wxTextBuffer &f, const wxString& text)
+
+void POWriter::String(std::string_view keyword, std::string_view value, const std::string& format)
 {
-    SplitIntoLines(text, [&f](wxString&& s, bool)
+    // allow room for the opening and closing quotes:
+    const int width = m_wrapStrings ? m_pageWidth - 2 : std::numeric_limits<int>::max() / 2;
+
+    const bool protectDirectives = m_wrapStrings && !format.empty();
+    if (protectDirectives)
+        MarkFormatDirectives(format, value, m_inDirective);
+
+    bool firstLine = true;
+    size_t start = 0;
+    do
     {
-        f.AddLine(s);
-    });
+        size_t end = value.find('\n', start);
+        end = (end == std::string_view::npos) ? value.size() : end + 1;
+        EscapePortion(value.substr(start, end - start), protectDirectives ? m_inDirective.data() + start : nullptr);
+
+        if (firstLine)
+        {
+            const int startColumn = int(keyword.size()) + 1;
+            ComputeBreaks(startColumn, width);
+
+            // If the value doesn't fit on the first line, use an empty first
+            // line and put the text on subsequent lines, as gettext does:
+            if (!m_portion.empty() && (end < value.size() || startColumn > width || !m_breaks.empty()))
+            {
+                m_out.append(keyword);
+                Line(" \"\"");
+                firstLine = false;
+                ComputeBreaks(0, width);
+            }
+        }
+        else
+        {
+            ComputeBreaks(0, width);
+        }
+
+        if (firstLine)
+        {
+            m_out.append(keyword);
+            m_out += ' ';
+            firstLine = false;
+        }
+
+        m_out += '"';
+        size_t pos = 0;
+        for (auto b: m_breaks)
+        {
+            m_out.append(m_portion, pos, b - pos);
+            m_out += '"';
+            Line();
+            m_out += '"';
+            pos = b;
+        }
+        m_out.append(m_portion, pos, std::string::npos);
+        m_out += '"';
+        Line();
+
+        start = end;
+    }
+    while (start < value.size());
 }
 
-/** Adds \n characters as necessary for good-looking output
- */
-wxString FormatStringForFile(const wxString& text)
+
+void POWriter::References(const wxArrayString& rawRefs)
 {
-    wxString s;
-    s.reserve(text.length() + 16);
+    if (rawRefs.empty())
+        return;
 
-    static wxString quoted_newline(wxS("\"\n\""));
+    m_out.append("#:");
+    int column = 2;
 
-    SplitIntoLines(text, [&s](wxString&& piece, bool last)
+    for (auto& raw: rawRefs)
     {
-        if (!s.empty())
-            s += quoted_newline;
-        if (!last)
-            piece += '\n';
-        EscapeCStringInplace(piece);
-        s += piece;
-    });
+        const auto utf8 = raw.utf8_str();
+        std::string_view s(utf8.data(), utf8.length());
+
+        // Split into whitespace-separated tokens, but keep filenames with
+        // spaces (enclosed in U+2068 FIRST STRONG ISOLATE ... U+2069 POP
+        // DIRECTIONAL ISOLATE) together:
+        static const std::string_view FSI("\xE2\x81\xA8"), PDI("\xE2\x81\xA9");
+        size_t pos = 0;
+        while (pos < s.size())
+        {
+            while (pos < s.size() && IsSpace(s[pos]))
+                pos++;
+            if (pos == s.size())
+                break;
+
+            size_t end = pos;
+            bool isolated = false;
+            while (end < s.size() && (isolated || !IsSpace(s[end])))
+            {
+                if (s.compare(end, FSI.size(), FSI) == 0)
+                    isolated = true;
+                else if (s.compare(end, PDI.size(), PDI) == 0)
+                    isolated = false;
+                end++;
+            }
 
-    return s;
+            auto token = s.substr(pos, end - pos);
+            const int len = int(token.size()) + 1;
+            if (column > 2 && column + len > m_pageWidth)
+            {
+                Line();
+                m_out.append("#:");
+                column = 2;
+            }
+            m_out += ' ';
+            m_out.append(token);
+            column += len;
+
+            pos = end;
+        }
+    }
+
+    Line();
 }
 
 } // anonymous namespace
@@ -1170,11 +2137,17 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
     const wxString po_file_temp = po_file_temp_obj.FileName();
 
     wxTextFileType outputCrlf = GetDesiredCRLFFormat(m_fileCRLF);
-    // Save into Unix line endings first and only if Windows is required,
-    // reformat the file later. This is because msgcat cannot handle DOS
-    // input particularly well.
 
-    if ( !DoSaveOnly(po_file_temp, wxTextFileType_Unix) )
+    // The file is written already formatted the way gettext tools format it.
+    // Re-formatting with msgcat, as older versions did, is still available as
+    // an option for compatibility with unusual gettext configurations. In that
+    // case, save into Unix line endings first and only if Windows is required,
+    // reformat the file later, because msgcat cannot handle DOS input
+    // particularly well.
+    const bool use_msgcat = wxConfig::Get()->ReadBool("format_po_with_msgcat", false);
+
+    std::unique_ptr<FileLayout> layout(new FileLayout);
+    if ( !DoSaveOnly(po_file_temp, use_msgcat ? wxTextFileType_Unix : outputCrlf, layout.get()) )
     {
         wxLogError(_(L"Couldn’t save file %s."), po_file.c_str());
         return false;
@@ -1182,7 +2155,11 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
 
     try
     {
-        validation_results = Validate(/*fileWithSameContent=*/po_file_temp);
+        // msgfmt is given a file with Unix line endings, same as msgcat above
+        if (use_msgcat || outputCrlf != wxTextFileType_Dos)
+            validation_results = Validate(/*fileWithSameContent=*/po_file_temp);
+        else
+            validation_results = Validate(wxString());
     }
     catch (...)
     {
@@ -1191,30 +2168,12 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
         wxLogError("%s", DescribeCurrentException());
     }
 
-    // Now that the file was written, run msgcat to re-format it according
-    // to the usual format. This is a (barely) passable fix for #25 until
-    // proper preservation of formatting is implemented.
-
     bool msgcat_ok = false;
+    if (use_msgcat)
     {
         wxArrayString args { "msgcat", "--force-po" };
 
-        int wrapping = DEFAULT_WRAPPING;
-        if (wxConfig::Get()->ReadBool("keep_crlf", true))
-            wrapping = m_fileWrappingWidth;
-
-        if (wrapping == DEFAULT_WRAPPING)
-        {
-            if (wxConfig::Get()->ReadBool("wrap_po_files", true))
-            {
-                wrapping = (int)wxConfig::Get()->ReadLong("wrap_po_files_width", 79);
-            }
-            else
-            {
-                wrapping = NO_WRAPPING;
-            }
-        }
-
+        int wrapping = GetOutputWrappingWidth();
         if (wrapping == NO_WRAPPING)
             args.push_back("--no-wrap");
         else if (wrapping != DEFAULT_WRAPPING)
@@ -1250,6 +2209,7 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
             msgcat_ok = false;
     }
 
+    bool saved_verbatim = false;
     if ( msgcat_ok )
     {
         wxRemoveFile(po_file_temp);
@@ -1260,6 +2220,10 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
         {
             wxLogError(_(L"Couldn’t save file %s."), po_file.c_str());
         }
+        else if ( !use_msgcat )
+        {
+            saved_verbatim = true;
+        }
         else
         {
             // Only shows msgcat's failure warning if we don't also get
@@ -1285,29 +2249,13 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
         TempOutputFileFor mo_file_temp_obj(mo_file);
         const wxString mo_file_temp = mo_file_temp_obj.FileName();
 
-        {
-            // Ignore msgfmt errors output (but not exit code), because it
-            // complains about things DoValidate() already complained above.
-            if (GettextRunner().run_sync("msgfmt", "-o", mo_file_temp, CliSafeFileName(po_file)))
-            {
-                mo_compilation_status = CompilationStatus::Success;
-            }
-            else
-            {
-                // Don't report errors, they were reported as part of validation
-                // step above.  Notice that we run msgfmt *without* the -c flag
-                // here to create the MO file in as many cases as possible, even if
-                // it has some errors.
-                //
-                // Still, msgfmt has the ugly habit of sometimes returning non-zero
-                // exit code, reporting "fatal errors" and *still* producing a usable
-                // .mo file. If this happens, don't pretend the file wasn't created.
-                if (wxFileName::FileExists(mo_file_temp))
-                    mo_compilation_status = CompilationStatus::Success;
-                else
-                    mo_compilation_status = CompilationStatus::Error;
-            }
-        }
+        // Don't report errors, they were reported as part of validation
+        // step above. The MO file is created in as many cases as possible,
+        // even if the catalog has some errors.
+        if (DoCompileMO(mo_file_temp))
+            mo_compilation_status = CompilationStatus::Success;
+        else
+            mo_compilation_status = CompilationStatus::Error;
 
         // Move the MO from temporary location to the final one, if it was created
         if (mo_compilation_status == CompilationStatus::Success)
@@ -1350,36 +2298,22 @@ bool POCatalog::Save(const wxString& po_file, bool save_mo,
 
     SetFileName(po_file);
 
+    // Remember where entries are in the file as written, so that the next save
+    // can only rewrite the changed ones:
+    for (auto& i: m_items)
+        i->ClearDirty();
+    if (saved_verbatim && layout->IsOk())
+        SetFileLayout(po_file, std::move(layout));
+    else
+        m_fileLayout.reset();
+
     return true;
 }
 
 
-std::string POCatalog::SaveToBuffer()
+bool POCatalog::SaveToStream(std::ostream& out)
 {
-    class StringSerializer : public wxMemoryText
-    {
-    public:
-        bool OnWrite(wxTextFileType typeNew, const wxMBConv& conv) override
-        {
-            size_t cnt = GetLineCount();
-            for (size_t n = 0; n < cnt; n++)
-            {
-                auto ln = GetLine(n) +
-                          GetEOL(typeNew == wxTextFileType_None ? GetLineType(n) : typeNew);
-                auto buf = ln.mb_str(conv);
-                buffer.append(buf.data(), buf.length());
-            }
-            return true;
-        }
-
-        std::string buffer;
-    };
-
-    StringSerializer f;
-
-    if (!DoSaveOnly(f, wxTextFileType_Unix))
-        return std::string();
-    return f.buffer;
+    return DoSaveToStream(out, wxTextFileType_Unix, GetOutputWrappingWidth());
 }
 
 
@@ -1389,35 +2323,14 @@ bool POCatalog::CompileToMO(const wxString& mo_file,
 {
     mo_compilation_status = CompilationStatus::NotDone;
 
-    TempDirectory tmpdir;
-    if ( !tmpdir.IsOk() )
-        return false;
-
-    wxFileName mofn(mo_file);
-    wxString po_file_temp = tmpdir.CreateFileName(mofn.GetName() + ".po");
-
-    if ( !DoSaveOnly(po_file_temp, wxTextFileType_Unix) )
-    {
-        wxLogError(_(L"Couldn’t save file %s."), po_file_temp.c_str());
-        return false;
-    }
-
-    validation_results = Validate(/*fileWithSameContent=*/po_file_temp);
+    // Both validation and compilation work with the in-memory catalog, no need
+    // to save it first (Validate() does that itself if msgfmt is used for it)
+    validation_results = Validate(wxString());
 
     TempOutputFileFor mo_file_temp_obj(mo_file);
     const wxString mo_file_temp = mo_file_temp_obj.FileName();
 
-    GettextRunner runner;
-    runner.run_sync("msgfmt", "-o", mo_file_temp, po_file_temp);
-
-    // Ignore msgfmt errors output (but not exit code), because it
-    // complains about things DoValidate() already complained above.
-    //
-    // Don't check return code either:
-    // msgfmt has the ugly habit of sometimes returning non-zero
-    // exit code, reporting "fatal errors" and *still* producing a usable
-    // .mo file. If this happens, don't pretend the file wasn't created.
-    if (!wxFileName::FileExists(mo_file_temp))
+    if (!DoCompileMO(mo_file_temp))
     {
         mo_compilation_status = CompilationStatus::Error;
         return false;
@@ -1427,28 +2340,160 @@ bool POCatalog::CompileToMO(const wxString& mo_file,
         mo_compilation_status = CompilationStatus::Success;
     }
 
-    if ( !mo_file_temp_obj.Commit() )
-    {
-        wxLogError(_(L"Couldn’t save file %s."), mo_file.c_str());
-        return false;
+    if ( !mo_file_temp_obj.Commit() )
+    {
+        wxLogError(_(L"Couldn’t save file %s."), mo_file.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+
+
+bool POCatalog::DoCompileMO(const wxString& mo_file)
+{
+    const wxString charset = m_header.Charset.Lower();
+    std::unique_ptr<wxCSConv> conv;
+    if (!charset.empty() && charset != "utf-8" && charset != "utf8" && charset != "charset")
+        conv.reset(new wxCSConv(m_header.Charset));
+
+    bool useMsgfmt = false;
+    auto encode = [&conv, &useMsgfmt](const wxString& str)
+    {
+        if (!conv)
+        {
+            const auto utf8 = str.utf8_str();
+            return std::string(utf8.data(), utf8.length());
+        }
+        const auto converted = str.mb_str(*conv);
+        if (converted.length() == 0 && !str.empty())
+            useMsgfmt = true;
+        return std::string(converted.data(), converted.length());
+    };
+
+    auto needsMsgfmt = [](const CatalogItemPtr& item)
+    {
+        const auto format = item->GetFormatFlag();
+        if (format != "c" && format != "objc")
+            return false;
+        if (MOCompiler::NeedsSystemDependentStrings(item->GetRawString()))
+            return true;
+        for (auto& t: item->GetTranslations())
+        {
+            if (MOCompiler::NeedsSystemDependentStrings(t))
+                return true;
+        }
+        return false;
+    };
+
+    MOCompiler mo;
+
+    const wxString header = UnescapeCString(m_header.ToString(wxString()));
+    if (!header.empty())
+        mo.AddMessage(std::string(), encode(header));
+
+    const auto pluralsCount = std::max(GetPluralFormsCountPresentInItems(), GetPluralForms().nplurals());
+
+    for (auto& item: m_items)
+    {
+        // Like msgfmt, don't emit untranslated and fuzzy entries
+        if (item->IsFuzzy() || item->GetTranslation().empty())
+            continue;
+
+        if (needsMsgfmt(item))
+        {
+            useMsgfmt = true;
+            break;
+        }
+
+        std::string key;
+        if (item->HasContext())
+        {
+            key = encode(item->GetContext());
+            key += '\x04';
+        }
+        key += encode(item->GetRawString());
+
+        std::string translation;
+        if (item->HasPlural())
+        {
+            key += '\0';
+            key += encode(item->GetRawPluralString());
+
+            for (unsigned i = 0; i < pluralsCount; i++)
+            {
+                if (i > 0)
+                    translation += '\0';
+                translation += encode(item->GetTranslation(i));
+            }
+        }
+        else
+        {
+            translation = encode(item->GetTranslation());
+        }
+
+        mo.AddMessage(std::move(key), std::move(translation));
     }
 
-    return true;
-}
+    if (!useMsgfmt)
+        return mo.WriteFile(mo_file);
 
+    // Fall back to msgfmt for what the built-in compiler can't handle
+    // (system-dependent strings, or content not representable in the
+    // catalog's charset):
+    wxLogTrace("poedit", "compiling %s with msgfmt", mo_file);
+
+    TempDirectory tmpdir;
+    if ( !tmpdir.IsOk() )
+        return false;
+    wxString po_file_temp = tmpdir.CreateFileName("compiled.po");
+    if ( !DoSaveOnly(po_file_temp, wxTextFileType_Unix) )
+        return false;
 
+    // Ignore msgfmt errors output and exit code: msgfmt has the ugly habit of
+    // sometimes returning non-zero exit code, reporting "fatal errors" and
+    // *still* producing a usable .mo file. If this happens, don't pretend the
+    // file wasn't created.
+    GettextRunner().run_sync("msgfmt", "-o", mo_file, CliSafeFileName(po_file_temp));
+    return wxFileName::FileExists(mo_file);
+}
 
 
-bool POCatalog::DoSaveOnly(const wxString& po_file, wxTextFileType crlf)
+bool POCatalog::DoSaveOnly(const wxString& po_file, wxTextFileType crlf, FileLayout *layout)
 {
-    wxTextFile f;
-    if (!f.Create(po_file))
+    std::ofstream f(po_file.fn_str(), std::ios::binary | std::ios::trunc);
+    if (!f)
+        return false;
+    if (!DoSaveToStream(f, crlf, GetOutputWrappingWidth(), layout))
         return false;
+    f.close();
+    return !f.fail();
+}
+
+int POCatalog::GetOutputWrappingWidth() const
+{
+    int wrapping = DEFAULT_WRAPPING;
+    if (wxConfig::Get()->ReadBool("keep_crlf", true))
+        wrapping = m_fileWrappingWidth;
+
+    if (wrapping == DEFAULT_WRAPPING)
+    {
+        if (wxConfig::Get()->ReadBool("wrap_po_files", true))
+        {
+            wrapping = (int)wxConfig::Get()->ReadLong("wrap_po_files_width", 79);
+        }
+        else
+        {
+            wrapping = NO_WRAPPING;
+        }
+    }
 
-    return DoSaveOnly(f, crlf);
+    return wrapping;
 }
 
-bool POCatalog::DoSaveOnly(wxTextBuffer& f, wxTextFileType crlf)
+bool POCatalog::DoSaveToStream(std::ostream& output, wxTextFileType crlf, int wrapping, FileLayout *layout)
 {
     const bool isPOT = m_fileType == Type::POT;
 
@@ -1456,93 +2501,205 @@ bool POCatalog::DoSaveOnly(wxTextBuffer& f, wxTextFileType crlf)
     if (!m_header.Charset || m_header.Charset == "CHARSET")
         m_header.Charset = "UTF-8";
 
-    SaveMultiLines(f, m_header.Comment);
-    if (isPOT)
-        f.AddLine(wxS("#, fuzzy"));
-    f.AddLine(wxS("msgid \"\""));
-    f.AddLine(wxS("msgstr \"\""));
-    wxString pohdr = wxString(wxS("\"")) + m_header.ToString(wxS("\"\n\""));
-    pohdr.RemoveLast();
-    SaveMultiLines(f, pohdr);
-    f.AddLine(wxEmptyString);
+    const wxString charset = m_header.Charset.Lower();
+    const bool isUTF8 = charset == "utf-8" || charset == "utf8";
 
-    auto pluralsCount = std::max(GetPluralFormsCountPresentInItems(), GetPluralForms().nplurals());
+    const unsigned pluralsCount = std::max(GetPluralFormsCountPresentInItems(), GetPluralForms().nplurals());
 
-    for (auto& data_: m_items)
+    auto writeHeader = [&](POWriter& f)
     {
-        auto data = std::static_pointer_cast<POCatalogItem>(data_);
+        f.Lines(m_header.Comment);
+        if (isPOT)
+            f.Line("#, fuzzy");
+        f.Line("msgid \"\"");
+        f.String("msgstr", UnescapeCString(m_header.ToString(wxString())));
+    };
 
-        data->SetLineNumber(int(f.GetLineCount()+1));
-        SaveMultiLines(f, data->GetComment());
-        for (unsigned i = 0; i < data->GetExtractedComments().GetCount(); i++)
+    auto writeItem = [&](POWriter& f, POCatalogItem& data)
+    {
+        f.Lines(data.GetComment());
+        for (auto& extracted: data.GetExtractedComments())
         {
-            if (data->GetExtractedComments()[i].empty())
-              f.AddLine(wxS("#."));
+            if (extracted.empty())
+                f.Line("#.");
             else
-              f.AddLine(wxS("#. ") + data->GetExtractedComments()[i]);
-        }
-        for (unsigned i = 0; i < data->GetRawReferences().GetCount(); i++)
-            f.AddLine(wxS("#: ") + data->GetRawReferences()[i]);
-        wxString dummy = data->GetFlags();
-        if (!dummy.empty())
-            f.AddLine(wxS("#") + dummy);
-        for (unsigned i = 0; i < data->GetOldMsgidRaw().GetCount(); i++)
-            f.AddLine(wxS("#| ") + data->GetOldMsgidRaw()[i]);
-        if ( data->HasContext() )
-        {
-            SaveMultiLines(f, wxS("msgctxt \"") + FormatStringForFile(data->GetContext()) + wxS("\""));
+                f.Line("#. ", extracted);
         }
-        dummy = FormatStringForFile(data->GetRawString());
-        SaveMultiLines(f, wxS("msgid \"") + dummy + wxS("\""));
-        if (data->HasPlural())
+        f.References(data.GetRawReferences());
+        wxString flags = data.GetFlags();
+        if (!flags.empty())
+            f.Line("#", flags);
+        for (auto& old: data.GetOldMsgidRaw())
+            f.Line("#| ", old);
+        const auto format = data.GetFormatFlag();
+        if ( data.HasContext() )
+            f.String("msgctxt", data.GetContext(), format);
+        // same as the parser does, line number is that of msgid:
+        data.SetLineNumber(f.NextLineNumber());
+        f.String("msgid", data.GetRawString(), format);
+        if (data.HasPlural())
         {
-            dummy = FormatStringForFile(data->GetRawPluralString());
-            SaveMultiLines(f, wxS("msgid_plural \"") + dummy + wxS("\""));
+            f.String("msgid_plural", data.GetRawPluralString(), format);
 
             for (unsigned i = 0; i < pluralsCount; i++)
             {
-                dummy = FormatStringForFile(data->GetTranslation(i));
-                wxString hdr = wxString::Format(wxS("msgstr[%u] \""), i);
-                SaveMultiLines(f, hdr + dummy + wxS("\""));
+                char keyword[32];
+                snprintf(keyword, sizeof(keyword), "msgstr[%u]", i);
+                f.String(keyword, data.GetTranslation(i), format);
             }
         }
         else
         {
             if (isPOT)
+                f.Line("msgstr \"\"");
+            else
+                f.String("msgstr", data.GetTranslation(), format);
+        }
+    };
+
+    FileLayout outLayout;
+    outLayout.crlf = crlf;
+    outLayout.wrapping = wrapping;
+    outLayout.pluralsCount = pluralsCount;
+    outLayout.items.reserve(m_items.size());
+
+    // items' line numbers are updated to match the output below:
+    MarkItemsChanged();
+
+    // Non-Unicode charsets are rare; output in them is written as UTF-8 first
+    // and then converted at once at the end:
+    namespace io = boost::iostreams;
+    std::string utf8Output;
+    io::stream<io::back_insert_device<std::string>> utf8Stream(utf8Output);
+
+    POWriter f(crlf, wrapping, isUTF8 ? &output : &utf8Stream);
+
+    auto previous = isUTF8 ? OpenPreviousFile(crlf, wrapping, pluralsCount) : nullptr;
+    if (previous)
+    {
+        // Only the header and changed items are written, the rest of the file
+        // is copied verbatim. Line numbers of unchanged entries are their lines
+        // in the previous file shifted by the difference in length of preceding
+        // rewritten entries; they're always computed from the previous file, so
+        // that repeated outputs (uploads, temporary files) don't accumulate shifts.
+        const std::string_view prev = previous->view();
+
+        size_t pos = 0;     // end of the already processed part of prev
+        int lineDelta = 0;  // line numbers difference between output and prev at pos
+
+        auto replaceSpan = [&](const FileLayout::Span& span, auto&& write)
+        {
+            f.Verbatim(prev.substr(pos, span.offset - pos));
+            auto old = prev.substr(span.offset, span.length);
+            lineDelta -= (int)std::count(old.begin(), old.end(), '\n');
+
+            FileLayout::Span written;
+            written.offset = f.Offset();
+            const int firstLine = f.NextLineNumber();
+            write();
+            lineDelta += f.NextLineNumber() - firstLine;
+            written.length = f.Offset() - written.offset;
+
+            pos = span.offset + span.length;
+            return written;
+        };
+
+        outLayout.header = replaceSpan(m_fileLayout->header, [&]{ writeHeader(f); });
+        const int headerDelta = lineDelta;
+
+        auto& prevLines = m_fileLayout->itemLines;
+        // line numbers difference after each item, for deleted entries below:
+        std::vector<int> deltas;
+        deltas.reserve(m_items.size());
+
+        for (size_t i = 0; i < m_items.size(); i++)
+        {
+            auto& item = static_cast<POCatalogItem&>(*m_items[i]);
+            auto& span = m_fileLayout->items[i];
+            if (item.IsDirty())
             {
-                f.AddLine(wxS("msgstr \"\""));
+                outLayout.items.push_back(replaceSpan(span, [&]{ writeItem(f, item); }));
+                f.Flush();
             }
             else
             {
-                dummy = FormatStringForFile(data->GetTranslation());
-                SaveMultiLines(f, wxS("msgstr \"") + dummy + wxS("\""));
+                item.SetLineNumber(prevLines[i] + lineDelta);
+                FileLayout::Span moved;
+                moved.offset = span.offset - pos + f.Offset();
+                moved.length = span.length;
+                outLayout.items.push_back(moved);
             }
+            deltas.push_back(lineDelta);
         }
-        f.AddLine(wxEmptyString);
-    }
 
-    // Write back deleted items in the file so that they're not lost
-    for (unsigned itemIdx = 0; itemIdx < m_deletedItems.size(); itemIdx++)
+        f.Verbatim(prev.substr(pos));
+
+        // deleted entries are copied verbatim too, but may follow rewritten ones:
+        auto& prevDeletedLines = m_fileLayout->deletedItemLines;
+        for (size_t i = 0; i < m_deletedItems.size(); i++)
+        {
+            const int line = prevDeletedLines[i];
+            const size_t after = std::upper_bound(prevLines.begin(), prevLines.end(), line) - prevLines.begin();
+            m_deletedItems[i].SetLineNumber(line + (after == 0 ? headerDelta : deltas[after - 1]));
+        }
+    }
+    else
     {
-        if ( itemIdx != 0 )
-            f.AddLine(wxEmptyString);
+        writeHeader(f);
+        outLayout.header.length = f.Offset();
+        f.Line();
+
+        for (auto& data: m_items)
+        {
+            FileLayout::Span span;
+            span.offset = f.Offset();
+            writeItem(f, static_cast<POCatalogItem&>(*data));
+            span.length = f.Offset() - span.offset;
+            outLayout.items.push_back(span);
+            f.Line();
+            f.Flush();
+        }
 
-        POCatalogDeletedData& deletedItem = m_deletedItems[itemIdx];
-        deletedItem.SetLineNumber(int(f.GetLineCount()+1));
-        SaveMultiLines(f, deletedItem.GetComment());
-        for (unsigned i = 0; i < deletedItem.GetExtractedComments().GetCount(); i++)
-            f.AddLine(wxS("#. ") + deletedItem.GetExtractedComments()[i]);
-        for (unsigned i = 0; i < deletedItem.GetRawReferences().GetCount(); i++)
-            f.AddLine(wxS("#: ") + deletedItem.GetRawReferences()[i]);
-        wxString dummy = deletedItem.GetFlags();
-        if (!dummy.empty())
-            f.AddLine(wxS("#") + dummy);
+        // Write back deleted items in the file so that they're not lost
+        for (unsigned itemIdx = 0; itemIdx < m_deletedItems.size(); itemIdx++)
+        {
+            if ( itemIdx != 0 )
+                f.Line();
+
+            POCatalogDeletedData& deletedItem = m_deletedItems[itemIdx];
+            deletedItem.SetLineNumber(f.NextLineNumber());
+            f.Lines(deletedItem.GetComment());
+            for (auto& extracted: deletedItem.GetExtractedComments())
+                f.Line("#. ", extracted);
+            f.References(deletedItem.GetRawReferences());
+            wxString flags = deletedItem.GetFlags();
+            if (!flags.empty())
+                f.Line("#", flags);
+
+            for (auto& line: deletedItem.GetDeletedLines())
+                f.Line(std::string_view(), line);
+            f.Flush();
+        }
+    }
+
+    if (!f.Flush())
+        return false;
 
-        for (size_t j = 0; j < deletedItem.GetDeletedLines().GetCount(); j++)
-            f.AddLine(deletedItem.GetDeletedLines()[j]);
+    if (isUTF8)
+    {
+        if (layout)
+            *layout = std::move(outLayout);
+        return true;
     }
 
-    if (!CanEncodeToCharset(f, m_header.Charset))
+    // Output in other charsets can't be saved incrementally later:
+    if (layout)
+        *layout = FileLayout();
+
+    utf8Stream.flush();
+    const wxString text = wxString::FromUTF8(utf8Output.data(), utf8Output.size());
+    const wxCharBuffer converted = text.mb_str(wxCSConv(m_header.Charset));
+    if (converted.length() == 0 && !text.empty())
     {
 #if wxUSE_GUI
         wxString msg;
@@ -1554,12 +2711,62 @@ bool POCatalog::DoSaveOnly(wxTextBuffer& f, wxTextFileType crlf)
         m_header.Charset = "UTF-8";
 
         // Re-do the save again because we modified a header:
-        f.Clear();
-        return DoSaveOnly(f, crlf);
+        return DoSaveToStream(output, crlf, wrapping, layout);
+    }
+
+    output.write(converted.data(), converted.length());
+    return output.good();
+}
+
+std::unique_ptr<MappedFile> POCatalog::OpenPreviousFile(wxTextFileType crlf, int wrapping, unsigned pluralsCount) const
+{
+    if (!m_fileLayout)
+        return nullptr;
+
+    // Copied entries must look the same as if they were written now:
+    auto& layout = *m_fileLayout;
+    if (layout.crlf != crlf || layout.wrapping != wrapping || layout.pluralsCount != pluralsCount)
+        return nullptr;
+    if (layout.items.size() != m_items.size() || layout.itemLines.size() != m_items.size())
+        return nullptr;
+    if (layout.deletedItemLines.size() != m_deletedItems.size())
+        return nullptr;
+
+    // ...and the file must not have been modified by somebody else since:
+    wxFileName fn(layout.filename);
+    if (!fn.FileExists() || fn.GetSize() != layout.fileSize || fn.GetModificationTime() != layout.fileModTime)
+    {
+        wxLogTrace("poedit", "file %s changed on disk, saving it in full", layout.filename);
+        return nullptr;
     }
 
-    // Otherwise everything can be safely saved:
-    return f.Write(crlf, wxCSConv(m_header.Charset));
+    std::unique_ptr<MappedFile> file(new MappedFile(layout.filename));
+    if (!file->IsOk() || file->size() != layout.fileSize)
+        return nullptr;
+
+    return file;
+}
+
+void POCatalog::SetFileLayout(const wxString& filename, std::unique_ptr<FileLayout> layout)
+{
+    wxFileName fn(filename);
+    layout->filename = filename;
+    layout->fileSize = fn.GetSize();
+    layout->fileModTime = fn.GetModificationTime();
+
+    // items' line numbers describe the file when it was just loaded or saved:
+    layout->itemLines.clear();
+    layout->itemLines.reserve(m_items.size());
+    for (auto& i: m_items)
+        layout->itemLines.push_back(i->GetLineNumber());
+    layout->deletedItemLines.clear();
+    for (auto& d: m_deletedItems)
+        layout->deletedItemLines.push_back(d.GetLineNumber());
+
+    if (layout->fileSize == wxInvalidSize || !layout->fileModTime.IsValid())
+        m_fileLayout.reset();
+    else
+        m_fileLayout = std::move(layout);
 }
 
 void POCatalog::SetLanguage(Language lang)
@@ -1600,19 +2807,203 @@ bool POCatalog::HasWrongPluralFormsCount() const
 }
 
 
+namespace
+{
+
+// Identifies message for the purpose of finding duplicates; refers to item's data
+struct DuplicateKey
+{
+    const CatalogItem *item;
+
+    bool operator==(const DuplicateKey& other) const
+    {
+        return item->HasContext() == other.item->HasContext() &&
+               item->GetContext() == other.item->GetContext() &&
+               item->GetRawString() == other.item->GetRawString();
+    }
+};
+
+struct DuplicateKeyHash
+{
+    size_t operator()(const DuplicateKey& key) const
+    {
+        wxStringHash hash;
+        size_t h = hash(key.item->GetRawString());
+        if (key.item->HasContext())
+            h = h * 31 + hash(key.item->GetContext()) + 1;
+        return h;
+    }
+};
+
+typedef std::unordered_set<DuplicateKey, DuplicateKeyHash> DuplicateKeySet;
+
+void AppendUnique(wxArrayString& to, const wxArrayString& from)
+{
+    for (auto& s: from)
+    {
+        if (to.Index(s) == wxNOT_FOUND)
+            to.push_back(s);
+    }
+}
+
+} // anonymous namespace
+
+
 bool POCatalog::HasDuplicateItems() const
 {
-    typedef std::pair<wxString, wxString> MsgId;
-    std::set<MsgId> ids;
+    DuplicateKeySet ids;
+    ids.reserve(m_items.size());
     for (auto& item: m_items)
     {
-        if (!ids.emplace(std::make_pair(item->GetContext(), item->GetRawString())).second)
+        if (!ids.insert(DuplicateKey{item.get()}).second)
             return true;
     }
     return false;
 }
 
 bool POCatalog::FixDuplicateItems()
+{
+    if (wxConfig::Get()->ReadBool("fix_duplicates_with_msguniq", false))
+        return FixDuplicateItemsWithMsguniq();
+
+    // Find duplicates of the first occurrence of every message:
+    std::unordered_map<DuplicateKey, size_t, DuplicateKeyHash> firstOccurrence;
+    firstOccurrence.reserve(m_items.size());
+    std::map<size_t, std::vector<POCatalogItemPtr>> duplicates;
+    CatalogItemArray unique;
+    unique.reserve(m_items.size());
+    for (auto& item: m_items)
+    {
+        auto r = firstOccurrence.emplace(DuplicateKey{item.get()}, unique.size());
+        if (r.second)
+            unique.push_back(item);
+        else
+            duplicates[r.first->second].push_back(std::static_pointer_cast<POCatalogItem>(item));
+    }
+    firstOccurrence.clear();  // refers to items that are about to be modified
+
+    if (duplicates.empty())
+        return true;
+
+    wxLogTrace("poedit", "merging %d duplicate messages", (int)(m_items.size() - unique.size()));
+
+    // msgcat's marker of conflicting translations:
+    const wxString conflictMarker = wxString::Format("#-#-#-#-#  %s (%s)  #-#-#-#-#\n",
+                                                     wxFileName(m_fileName).GetFullName(),
+                                                     m_header.Project);
+
+    for (auto& d: duplicates)
+        MergeDuplicateItems(static_cast<POCatalogItem&>(*unique[d.first]), d.second, conflictMarker);
+
+    m_items = std::move(unique);
+    for (size_t i = 0; i < m_items.size(); i++)
+        static_cast<POCatalogItem&>(*m_items[i]).SetId(int(i + 1));
+
+    MarkItemsChanged();
+    m_fileLayout.reset();
+
+    return true;
+}
+
+void POCatalog::MergeDuplicateItems(POCatalogItem& item, const std::vector<POCatalogItemPtr>& duplicates, const wxString& conflictMarker)
+{
+    // Merge the entries the way msgcat/msguniq does: metadata are combined and
+    // if there are different translations, all of them are kept, separated by
+    // conflict markers, and the result is marked as fuzzy.
+    std::vector<const POCatalogItem*> all;
+    all.push_back(&item);
+    for (auto& d: duplicates)
+        all.push_back(d.get());
+
+    struct Variant
+    {
+        wxArrayString translations;
+        bool fuzzy;
+    };
+    std::vector<Variant> variants;
+
+    wxArrayString references, extractedComments, comments, flags;
+    for (auto i: all)
+    {
+        AppendUnique(references, i->GetRawReferences());
+        AppendUnique(extractedComments, i->GetExtractedComments());
+        if (i->HasComment() && comments.Index(i->GetComment()) == wxNOT_FOUND)
+            comments.push_back(i->GetComment());
+
+        wxStringTokenizer tkn(i->GetFlags(), ",");
+        while (tkn.HasMoreTokens())
+        {
+            auto flag = tkn.GetNextToken().Strip(wxString::both);
+            if (!flag.empty() && flag != "fuzzy" && flags.Index(flag) == wxNOT_FOUND)
+                flags.push_back(flag);
+        }
+
+        if (!item.HasPlural() && i->HasPlural())
+            item.SetPluralString(i->GetRawPluralString());
+        if (!item.HasOldMsgid() && i->HasOldMsgid())
+            item.SetOldMsgid(i->GetOldMsgidRaw());
+
+        const bool hasTranslation = std::any_of(i->GetTranslations().begin(), i->GetTranslations().end(),
+                                                [](const wxString& t){ return !t.empty(); });
+        if (!hasTranslation)
+            continue;
+        auto v = std::find_if(variants.begin(), variants.end(),
+                              [=](const Variant& x){ return x.translations == i->GetTranslations(); });
+        if (v == variants.end())
+            variants.push_back({i->GetTranslations(), i->IsFuzzy()});
+        else
+            v->fuzzy = v->fuzzy && i->IsFuzzy();
+    }
+
+    wxString moreFlags;
+    for (auto& f: flags)
+        moreFlags += ", " + f;
+
+    // comments are stored with trailing newlines already, don't add empty lines between them:
+    wxString comment;
+    for (auto& c: comments)
+    {
+        comment += c;
+        if (!c.EndsWith("\n"))
+            comment += '\n';
+    }
+
+    item.SetRawReferences(references);
+    item.SetExtractedComments(extractedComments);
+    item.SetComment(comment);
+    item.SetFlags(moreFlags);
+
+    if (variants.size() == 1)
+    {
+        item.SetTranslations(variants.front().translations);
+        item.SetFuzzy(variants.front().fuzzy);
+    }
+    else if (variants.size() > 1)
+    {
+        size_t count = 0;
+        for (auto& v: variants)
+            count = std::max(count, v.translations.size());
+
+        wxArrayString translations;
+        for (size_t form = 0; form < count; form++)
+        {
+            wxString merged;
+            for (auto& v: variants)
+            {
+                if (!merged.empty())
+                    merged += '\n';
+                merged += conflictMarker;
+                if (form < v.translations.size())
+                    merged += v.translations[form];
+            }
+            translations.push_back(merged);
+        }
+        item.SetTranslations(translations);
+        item.SetFuzzy(true);
+    }
+}
+
+bool POCatalog::FixDuplicateItemsWithMsguniq()
 {
     auto oldname = m_fileName;
 
@@ -1638,6 +3029,7 @@ bool POCatalog::FixDuplicateItems()
 
     Load(po_file_fixed);
     m_fileName = oldname;
+    m_fileLayout.reset();  // describes the temporary file
     PostCreation();
 
     return true;
@@ -1651,6 +3043,21 @@ Catalog::ValidationResults POCatalog::Validate(const wxString& fileWithSameConte
     if (!HasCapability(Catalog::Cap::Translations))
         return res;  // no errors in POT files
 
+    // The same checks as msgfmt -c does are performed in-process, as long as
+    // all used format strings' kinds are supported. Otherwise, and if asked
+    // to for compatibility, msgfmt itself is run.
+    if (!wxConfig::Get()->ReadBool("check_with_msgfmt", false))
+    {
+        GettextChecker checker(*this);
+        if (checker.SupportsAllFormats())
+        {
+            res.errors += checker.CheckItems();
+            for (auto& problem: checker.CheckHeader())
+                wxLogTrace("poedit", "header problem: %s", problem);
+            return res;
+        }
+    }
+
     if (!fileWithSameContent.empty())
     {
         ValidateWithMsgfmt(res, fileWithSameContent);
@@ -1721,6 +3128,8 @@ bool POCatalog::UpdateFromPOT(POCatalogPtr pot, bool replace_header)
         case Type::POT:
         {
             m_items = pot->m_items;
+            MarkItemsChanged();
+            m_fileLayout.reset();
             m_sourceLanguage = pot->m_sourceLanguage;
             m_sourceIsSymbolicID = pot->m_sourceIsSymbolicID;
             m_hasPluralItems = pot->m_hasPluralItems;
@@ -1747,51 +3156,322 @@ POCatalogPtr POCatalog::CreateFromPOT(POCatalogPtr pot)
         return nullptr;
 }
 
+namespace
+{
+
+// Key for exact matching of messages, distinguishing empty context from none
+std::wstring MakeMergeKey(const CatalogItem& item)
+{
+    std::wstring key;
+    if (item.HasContext())
+    {
+        key += L'\x01';
+        key += item.GetContext().ToStdWstring();
+        key += L'\x04';
+    }
+    key += item.GetRawString().ToStdWstring();
+    return key;
+}
+
+inline bool HasSameContext(const CatalogItem& a, const CatalogItem& b)
+{
+    return a.HasContext() == b.HasContext() && (!a.HasContext() || a.GetContext() == b.GetContext());
+}
+
+} // anonymous namespace
+
+
+std::vector<POCatalogItemPtr> POCatalog::ParseDeletedItems() const
+{
+    std::vector<POCatalogItemPtr> parsed(m_deletedItems.size());
+    if (m_deletedItems.empty())
+        return parsed;
+
+    // Put all obsolete entries, with the "#~" prefix removed, into one
+    // buffer, separated by empty lines, and parse them at once:
+    std::string text;
+    std::vector<unsigned> startLines;
+    unsigned line = 1;
+    for (auto& d: m_deletedItems)
+    {
+        startLines.push_back(line);
+        for (auto& raw: d.GetDeletedLines())
+        {
+            const auto utf8 = raw.utf8_str();
+            std::string_view s(utf8.data(), utf8.length());
+            if (StartsWith(s, "#~|"))
+            {
+                text += "#|";
+                s.remove_prefix(3);
+            }
+            else if (StartsWith(s, "#~"))
+            {
+                s.remove_prefix(StartsWith(s, "#~ ") ? 3 : 2);
+            }
+            text.append(s);
+            text += '\n';
+            line++;
+        }
+        text += '\n';
+        line++;
+    }
+
+    StringPool pool;
+    POLoadParser parser(text, pool);
+    parser.IgnoreHeader(true);
+    if (!parser.Parse() && !parser.GetError().empty())
+        wxLogError("%s", parser.GetError());
+
+    for (auto& item: parser.Items)
+    {
+        auto pos = std::upper_bound(startLines.begin(), startLines.end(), (unsigned)item->GetLineNumber());
+        if (pos == startLines.begin())
+            continue;
+        const size_t idx = pos - startLines.begin() - 1;
+        if (parsed[idx])
+            continue;  // malformed entry, use the first message only
+
+        auto& d = m_deletedItems[idx];
+        item->SetComment(d.GetComment());
+        if (!d.GetFlags().empty())
+            item->SetFlags(d.GetFlags());
+        parsed[idx] = item;
+    }
+
+    return parsed;
+}
+
+
 bool POCatalog::Merge(const POCatalogPtr& refcat)
 {
-    wxString oldname = m_fileName;
-    wxON_BLOCK_EXIT_SET(m_fileName, oldname);
+    // This does the same thing as msgmerge --previous, but in-process:
+    //
+    // - messages from the reference catalog are matched with existing ones,
+    //   including obsolete ones, by context and msgid
+    // - if there's no exact match, the most similar translated message with
+    //   the same context is used (unless fuzzy matching is disabled) and the
+    //   result is marked fuzzy, with the original msgid kept in #| comments
+    // - unused translated messages become obsolete
+    //
+    // Like msgmerge, translations and translator comments come from this
+    // catalog, everything else from the reference.
 
-    TempDirectory tmpdir;
-    if ( !tmpdir.IsOk() )
-        return false;
+    wxStopWatch sw;
+
+    const auto& refItems = refcat->items();
+    const bool fuzzyMatching = Config::MergeBehavior() != Merge_None;
 
-    wxString tmp1 = tmpdir.CreateFileName("ref.pot");
-    wxString tmp2 = tmpdir.CreateFileName("input.po");
-    wxString tmp3 = tmpdir.CreateFileName("output.po");
+    // All available definitions, current ones first:
+    std::vector<POCatalogItemPtr> defs;
+    defs.reserve(m_items.size() + m_deletedItems.size());
+    for (auto& i: m_items)
+        defs.push_back(std::static_pointer_cast<POCatalogItem>(i));
+    const size_t firstObsolete = defs.size();
 
-    refcat->DoSaveOnly(tmp1, wxTextFileType_Unix);
-    DoSaveOnly(tmp2, wxTextFileType_Unix);
+    const auto parsedDeleted = ParseDeletedItems();
+    std::vector<size_t> deletedIndex;
+    for (size_t j = 0; j < parsedDeleted.size(); j++)
+    {
+        if (!parsedDeleted[j])
+            continue;
+        defs.push_back(parsedDeleted[j]);
+        deletedIndex.push_back(j);
+    }
 
-    std::vector<wxString> args { "msgmerge", "-q", "--force-po", "--previous" };
-    if (Config::MergeBehavior() == Merge_None)
+    std::unordered_map<std::wstring, size_t> exact;
+    exact.reserve(defs.size());
+    FuzzyMatcher fuzzy;
+    for (size_t d = 0; d < defs.size(); d++)
     {
-        args.push_back("--no-fuzzy-matching");
+        exact.emplace(MakeMergeKey(*defs[d]), d);
+        if (fuzzyMatching && !defs[d]->GetTranslation().empty())
+            fuzzy.Add(defs[d]->GetRawString(), d);
     }
+    fuzzy.Build();
+
+    // Find matches for all messages in parallel:
+    struct MatchResult
+    {
+        int def = -1;
+        bool exact = false;
+    };
+    std::vector<MatchResult> matches(refItems.size());
+
+    dispatch::parallel_for(refItems.size(), [&](size_t i)
+    {
+        auto& ref = *refItems[i];
+        auto e = exact.find(MakeMergeKey(ref));
+        if (e != exact.end())
+        {
+            matches[i].def = (int)e->second;
+            matches[i].exact = true;
+            return;
+        }
+
+        if (!fuzzyMatching || ref.GetRawString().empty() || fuzzy.IsEmpty())
+            return;
+
+        FuzzyMatcher::Match m;
+        auto sameContext = [&](size_t d){ return HasSameContext(*defs[d], ref); };
+        if (fuzzy.FindBest(ref.GetRawString(), sameContext, m))
+            matches[i].def = (int)m.id;
+    });
+
+    // Build the result in reference catalog's order:
+    const int wrapping = GetOutputWrappingWidth();
+    POWriter prevWriter(wxTextFileType_Unix, wrapping > 0 ? std::max(wrapping - 3, 20) : wrapping);
+    auto formatPrevious = [&prevWriter](const CatalogItem& def)
+    {
+        const auto format = def.GetFormatFlag();
+        if (def.HasContext())
+            prevWriter.String("msgctxt", def.GetContext(), format);
+        prevWriter.String("msgid", def.GetRawString(), format);
+        if (def.HasPlural())
+            prevWriter.String("msgid_plural", def.GetRawPluralString(), format);
+        return prevWriter.TakeLines();
+    };
+
+    const unsigned nplurals = std::max(GetPluralForms().nplurals(), 1u);
+
+    std::vector<bool> used(defs.size(), false);
+    std::vector<CatalogItemPtr> items;
+    items.reserve(refItems.size());
+    bool hasPluralItems = false;
+    int fuzzyCount = 0;
+
+    for (size_t i = 0; i < refItems.size(); i++)
+    {
+        auto ref = std::static_pointer_cast<POCatalogItem>(refItems[i]);
+        auto item = std::make_shared<POCatalogItem>();
+
+        item->SetId(int(i + 1));
+        item->SetString(ref->GetRawString());
+        if (ref->HasPlural())
+        {
+            item->SetPluralString(ref->GetRawPluralString());
+            hasPluralItems = true;
+        }
+        if (ref->HasContext())
+            item->SetContext(ref->GetContext());
+        item->SetRawReferences(ref->GetRawReferences());
+        for (auto& c: ref->GetExtractedComments())
+            item->AddExtractedComments(c);
+        item->SetFlags(ref->GetFlags());
+        item->SetFuzzy(false);
+
+        auto& match = matches[i];
+        if (match.def == -1)
+        {
+            item->SetComment(ref->GetComment());
+            items.push_back(item);
+            continue;
+        }
 
-    args.push_back("-o");
-    args.push_back(tmp3);
-    args.push_back(tmp2);
-    args.push_back(tmp1);
+        auto& def = *defs[match.def];
+        used[match.def] = true;
 
-    GettextRunner runner;
-    auto output = runner.run_sync(args);
-    // FIXME: Don't do that here, report as part of return value instead
-    runner.parse_stderr(output).log_errors();
+        item->SetComment(def.GetComment());
 
-    if (output)
+        const bool pluralMismatch = ref->HasPlural() != def.HasPlural() ||
+                                    (ref->HasPlural() && ref->GetRawPluralString() != def.GetRawPluralString());
+        if (ref->HasPlural() == def.HasPlural())
+        {
+            item->SetTranslations(def.GetTranslations());
+        }
+        else if (ref->HasPlural())
+        {
+            wxArrayString forms;
+            for (unsigned n = 0; n < nplurals; n++)
+                forms.push_back(def.GetTranslation());
+            item->SetTranslations(forms);
+        }
+        else
+        {
+            item->SetTranslation(def.GetTranslation(0));
+        }
+
+        if (!match.exact || pluralMismatch || def.IsFuzzy())
+        {
+            item->SetFuzzy(true);
+            if (match.exact && def.IsFuzzy() && def.HasOldMsgid())
+                item->SetOldMsgid(def.GetOldMsgidRaw());
+            else if (!match.exact || pluralMismatch)
+                item->SetOldMsgid(formatPrevious(def));
+            if (!match.exact)
+                fuzzyCount++;
+        }
+
+        items.push_back(item);
+    }
+
+    // Unused translated messages become obsolete, existing obsolete entries
+    // stay unless they were brought back:
+    POCatalogDeletedDataArray deleted;
+    POWriter obsoleteWriter(wxTextFileType_Unix, wrapping > 0 ? std::max(wrapping - 3, 20) : wrapping);
+    for (size_t d = 0; d < firstObsolete; d++)
     {
-        const wxString charset = m_header.Charset;
+        auto& def = *defs[d];
+        if (used[d] || def.GetTranslation().empty())
+            continue;
+
+        wxArrayString lines;
+        for (auto& prev: def.GetOldMsgidRaw())
+            lines.push_back("#~| " + prev);
+        const auto format = def.GetFormatFlag();
+        if (def.HasContext())
+            obsoleteWriter.String("msgctxt", def.GetContext(), format);
+        obsoleteWriter.String("msgid", def.GetRawString(), format);
+        if (def.HasPlural())
+        {
+            obsoleteWriter.String("msgid_plural", def.GetRawPluralString(), format);
+            for (unsigned n = 0; n < def.GetNumberOfTranslations(); n++)
+            {
+                char keyword[32];
+                snprintf(keyword, sizeof(keyword), "msgstr[%u]", n);
+                obsoleteWriter.String(keyword, def.GetTranslation(n), format);
+            }
+        }
+        else
+        {
+            obsoleteWriter.String("msgstr", def.GetTranslation(), format);
+        }
+        for (auto& ln: obsoleteWriter.TakeLines())
+            lines.push_back("#~ " + ln);
 
-        Load(tmp3);
-        m_fileName = oldname;
-        PostCreation();
+        POCatalogDeletedData data(lines);
+        data.SetComment(def.GetComment());
+        data.SetFlags(def.GetFlags());
+        deleted.push_back(data);
+    }
 
-        // msgmerge doesn't always preserve the charset, it tends to pick
-        // the most generic one of the charsets used, so if we are merging with
-        // UTF-8 catalog, it will become UTF-8. Some people hate this.
-        m_header.Charset = charset;
+    std::vector<bool> revived(m_deletedItems.size(), false);
+    for (size_t k = 0; k < deletedIndex.size(); k++)
+    {
+        if (used[firstObsolete + k])
+            revived[deletedIndex[k]] = true;
     }
+    for (size_t j = 0; j < m_deletedItems.size(); j++)
+    {
+        if (!revived[j])
+            deleted.push_back(m_deletedItems[j]);
+    }
+
+    // Like msgmerge, update the template-related headers from the reference:
+    const auto& refHeader = refcat->Header();
+    if (!refHeader.CreationDate.empty())
+        m_header.CreationDate = refHeader.CreationDate;
+    if (refHeader.HasHeader("Report-Msgid-Bugs-To"))
+        m_header.SetHeader("Report-Msgid-Bugs-To", refHeader.GetHeader("Report-Msgid-Bugs-To"));
+
+    m_items = std::move(items);
+    MarkItemsChanged();
+    m_deletedItems = std::move(deleted);
+    m_fileLayout.reset();
+    m_hasPluralItems = hasPluralItems;
 
-    return (bool)output;
+    PostCreation();
+
+    wxLogTrace("poedit", "merged %d messages (%d fuzzy) in %ld ms", (int)m_items.size(), fuzzyCount, sw.Time());
+
+    return true;
 }
@@ -28,6 +28,15 @@
 
 #include "catalog.h"
 
+#include <wx/datetime.h>
+#include <wx/longlong.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class MappedFile;
 class POCatalogItem;
 class POCatalog;
 typedef std::shared_ptr<POCatalogItem> POCatalogItemPtr;
@@ -43,16 +52,35 @@ public:
     wxArrayString GetReferences() const override;
 
 protected:
-    const wxArrayString& GetRawReferences() const { return m_references; }
-    void SetRawReferences(const wxArrayString& ref) { m_references = ref; }
+    const wxArrayString& GetRawReferences() const { EnsureDeferredDataLoaded(); return StringPool::Get(m_references); }
+    void SetRawReferences(const wxArrayString& ref) { EnsureDeferredDataLoaded(); m_references = StringPool::Wrap(ref); m_isDirty = true; }
 
     void UpdateInternalRepresentation() override {}
+    void InternData(StringPool& pool) override;
+    void LoadDeferredData() override;
+
+    /**
+        Raw lines of references, extracted comments and old msgid, in this
+        order and each terminated with '\n', kept until they are first needed.
+        The buffer is shared by all items loaded from the same data.
+     */
+    struct DeferredLines
+    {
+        std::shared_ptr<const std::string> buffer;
+        size_t offset = 0, length = 0;
+        uint32_t references = 0, extractedComments = 0, oldMsgid = 0;
+    };
+
+    /// Defers parsing of the lines until they are needed
+    void SetDeferredLines(DeferredLines&& lines);
 
     friend class POLoadParser;
     friend class POCatalog;
+    friend class CatalogCache;
 
 protected:
-    wxArrayString m_references;
+    InternedStringArray m_references;
+    DeferredLines m_deferredLines;
 };
 
 
@@ -188,7 +216,7 @@ public:
               ValidationResults& validation_results,
               CompilationStatus& mo_compilation_status) override;
 
-    std::string SaveToBuffer() override;
+    bool SaveToStream(std::ostream& out) override;
 
     ValidationResults Validate(const wxString& fileWithSameContent) override;
 
@@ -207,14 +235,15 @@ public:
     /// Detect a particular common breakage of catalogs.
     bool HasDuplicateItems() const;
 
-    /// Fixes a common invalid kind of entries, when msgids aren't unique.
+    /// Fixes a common invalid kind of entries, when msgids aren't unique,
+    /// by merging the duplicates the same way msguniq would.
     bool FixDuplicateItems();
 
     bool HasDeletedItems() const override
         { return !m_deletedItems.empty(); }
 
     void RemoveDeletedItems() override
-        { m_deletedItems.clear(); }
+        { m_deletedItems.clear(); m_fileLayout.reset(); }
 
     /// Updates the catalog from POT file.
     bool UpdateFromPOT(const wxString& pot_file, bool replace_header = false);
@@ -238,7 +267,7 @@ protected:
     /// Adds entry to the catalog (the catalog will take ownership of
     /// the object).
     void AddItem(const POCatalogItemPtr& data)
-        { m_items.push_back(data); }
+        { AppendItem(data); }
 
     /// Adds entry to the catalog (the catalog will take ownership of
     /// the object).
@@ -249,9 +278,63 @@ protected:
     /// Fix commonly encountered fixable problems with loaded files
     void FixupCommonIssues();
 
+    /**
+        Location of entries in the file the catalog was loaded from or last
+        saved to, used to only re-serialize changed entries when saving.
+     */
+    struct FileLayout
+    {
+        struct Span
+        {
+            size_t offset = 0, length = 0;
+        };
+
+        wxString filename;
+        wxULongLong fileSize;
+        wxDateTime fileModTime;
+
+        // formatting of the file's entries
+        wxTextFileType crlf = wxTextFileType_None;
+        int wrapping = NO_WRAPPING;
+        unsigned pluralsCount = 0;
+
+        Span header;
+        std::vector<Span> items;    ///< same order as m_items
+
+        // line numbers of entries in the file, same order as m_items and m_deletedItems
+        std::vector<int> itemLines, deletedItemLines;
+
+        bool IsOk() const { return header.length != 0; }
+    };
+
     void ValidateWithMsgfmt(ValidationResults& res, const wxString& po_file);
-    bool DoSaveOnly(const wxString& po_file, wxTextFileType crlf);
-    bool DoSaveOnly(wxTextBuffer& f, wxTextFileType crlf);
+    bool DoSaveOnly(const wxString& po_file, wxTextFileType crlf, FileLayout *layout = nullptr);
+
+    /// Compiles the catalog into MO file, without validating it.
+    bool DoCompileMO(const wxString& mo_file);
+
+    /** Serializes the catalog into PO file data, formatted the same way
+        gettext tools would format it.
+
+        If the catalog's file is unchanged since it was loaded or saved, only
+        changed items are serialized and the rest is copied from the file.
+        The output is written into the stream as it's being produced.
+
+        \param output    Receives file's content, in header's charset.
+        \param crlf      Line endings to use.
+        \param wrapping  Line width or NO_WRAPPING.
+        \param layout    If not null, receives layout of the output.
+     */
+    bool DoSaveToStream(std::ostream& output, wxTextFileType crlf, int wrapping, FileLayout *layout = nullptr);
+
+    /// Returns the file described by m_fileLayout if it can be used for saving with given settings.
+    std::unique_ptr<MappedFile> OpenPreviousFile(wxTextFileType crlf, int wrapping, unsigned pluralsCount) const;
+
+    /// Starts using @a layout of file @a filename, as just loaded or saved.
+    void SetFileLayout(const wxString& filename, std::unique_ptr<FileLayout> layout);
+
+    /// Returns the wrapping width to use when saving, per file and user preferences.
+    int GetOutputWrappingWidth() const;
 
     /** Merges the catalog with reference catalog
         (in the sense of msgmerge -- this catalog is old one with
@@ -263,6 +346,15 @@ protected:
      */
     bool Merge(const POCatalogPtr& refcat);
 
+    /// Merges @a duplicates of the same message into @a item.
+    void MergeDuplicateItems(POCatalogItem& item, const std::vector<POCatalogItemPtr>& duplicates, const wxString& conflictMarker);
+
+    /// Legacy implementation of FixDuplicateItems() that runs msguniq.
+    bool FixDuplicateItemsWithMsguniq();
+
+    /// Parses obsolete entries; returns nullptr for entries that aren't messages
+    std::vector<POCatalogItemPtr> ParseDeletedItems() const;
+
 protected:
     POCatalogDeletedDataArray m_deletedItems;
 
@@ -270,17 +362,51 @@ protected:
     int m_fileWrappingWidth;
     bool m_hasPluralItems = false;
 
-    friend class POLoadParser;
+    std::unique_ptr<FileLayout> m_fileLayout;
+
+    /// Hash of the loaded file for CatalogCache, 0 if not computed
+    uint64_t m_loadedContentHash = 0;
+
     friend class Catalog;
+    friend class CatalogCache;
 };
 
 
-/// Internal class - used for parsing of po files.
+/**
+    Internal class - used for parsing of po files.
+
+    Works directly on UTF-8 encoded file content without copying it: parsed
+    values are passed to OnEntry() as views into the input, or, if they had
+    to be unescaped or joined from several lines, into an arena owned by the
+    parser. Conversion to wxString is left to the consumer.
+ */
 class POCatalogParser
 {
 public:
-    POCatalogParser(wxTextFile *f)
-        : m_textFile(f),
+    /// Data of a single parsed entry; views are valid for parser's lifetime
+    struct Entry
+    {
+        std::string_view msgid, msgid_plural, context;
+        std::string_view flags;     ///< e.g. ", fuzzy, c-format"
+        std::string_view comment;   ///< translator comment lines, "\n"-terminated
+        std::vector<std::string_view> translations;
+        std::vector<std::string_view> references;
+        std::vector<std::string_view> extractedComments;
+        std::vector<std::string_view> msgidOld;
+        std::vector<std::string_view> deletedLines;
+        std::string_view source;    ///< entry's raw text, from its first line up to and including the last EOL
+        bool hasPlural = false;
+        bool hasContext = false;
+        unsigned lineNumber = 0;
+
+        void Clear();
+    };
+
+    /// Creates parser for UTF-8 encoded @a data, which must outlive the parser.
+    explicit POCatalogParser(std::string_view data)
+        : m_data(data),
+          m_pos(0),
+          m_lineNumber(0),
           m_detectedLineWidth(0),
           m_detectedWrappedLines(false),
           m_lastLineHardWrapped(true), m_previousLineHardWrapped(true),
@@ -305,9 +431,30 @@ public:
 
     int GetWrappingWidth() const;
 
+    /// Returns predominant line endings used in the file (Unix, Dos or None if not known)
+    wxTextFileType GetLineEndingsFormat() const;
+
+    /// Number of lines consumed by Parse()
+    unsigned GetLinesCount() const { return m_lineNumber; }
+
+    /// Description of the problem if Parse() failed because of malformed data
+    const wxString& GetError() const { return m_error; }
+
+    /**
+        Splits @a data into at most @a maxChunks parts that can be parsed
+        independently, for parsing large files in parallel.
+
+        Splits are only done at blank lines between complete entries. Small
+        inputs are always returned as a single chunk.
+     */
+    static std::vector<std::string_view> SplitIntoChunks(std::string_view data, size_t maxChunks);
+
+    /// Merges information about formatting (wrapping, line endings) gathered by parser of the next chunk
+    void AccumulateFormatInfo(const POCatalogParser& next);
+
 protected:
-    // Read one line from file, remove all \r and \n characters, ignore empty lines:
-    wxString ReadTextLine();
+    // Read one line from input, strip whitespace and EOL characters, ignore empty lines:
+    std::string_view ReadTextLine();
 
     void PossibleWrappedLine()
     {
@@ -319,37 +466,49 @@ protected:
         if returned value is true and is cancelled if it
         is false.
      */
-    virtual bool OnEntry(const wxString& msgid,
-                         const wxString& msgid_plural,
-                         bool has_plural,
-                         bool has_context,
-                         const wxString& context,
-                         const wxArrayString& mtranslations,
-                         const wxString& flags,
-                         const wxArrayString& references,
-                         const wxString& comment,
-                         const wxArrayString& extractedComments,
-                         const wxArrayString& msgid_old,
-                         unsigned lineNumber) = 0;
+    virtual bool OnEntry(const Entry& entry) = 0;
 
     /** Called when new deleted entry was parsed. Parsing continues
         if returned value is true and is cancelled if it
         is false. Defaults to an empty implementation.
      */
-    virtual bool OnDeletedEntry(const wxArrayString& /*deletedLines*/,
-                                const wxString& /*flags*/,
-                                const wxArrayString& /*references*/,
-                                const wxString& /*comment*/,
-                                const wxArrayString& /*extractedComments*/,
-                                unsigned /*lineNumber*/)
+    virtual bool OnDeletedEntry(const Entry& /*entry*/)
     {
         return true;
     }
 
     virtual void OnIgnoredEntry() {}
 
-    /// Textfile being parsed.
-    wxTextFile *m_textFile;
+private:
+    /// Bump allocator for unescaped values, freed all at once with the parser
+    class Arena
+    {
+    public:
+        char *Allocate(size_t size);
+
+    private:
+        std::vector<std::unique_ptr<char[]>> m_blocks;
+        char *m_current = nullptr;
+        size_t m_available = 0;
+    };
+
+    // Reads quoted string continuation lines following the first segment
+    std::string_view ReadQuotedValue(std::string_view first, std::string_view& line);
+    // Unescapes and joins segments of a value
+    std::string_view Unescape(const std::vector<std::string_view>& segments);
+    // Joins parts, optionally adding a suffix after each of them
+    std::string_view Join(const std::vector<std::string_view>& parts, char suffix = 0);
+
+protected:
+    /// Content being parsed.
+    std::string_view m_data;
+    size_t m_pos;
+    unsigned m_lineNumber;
+    wxString m_error;
+    // Offsets of the last line returned by ReadTextLine() and end of the one before it:
+    size_t m_lineStart = 0, m_lineEnd = 0, m_prevLineEnd = 0;
+    size_t m_eolCount[wxTextFileType_Mac + 1] = {};
+
     int m_detectedLineWidth;
     bool m_detectedWrappedLines;
     bool m_lastLineHardWrapped, m_previousLineHardWrapped;
@@ -359,6 +518,10 @@ protected:
 
     /// Whether the translations should be ignored (as if it was a POT)
     bool m_ignoreTranslations;
+
+private:
+    Arena m_arena;
+    std::vector<std::string_view> m_segments;
 };
 
 #endif // Poedit_catalog_po_h
@@ -94,7 +94,7 @@ QtLinguistCatalogItem::QtLinguistCatalogItem(QtLinguistCatalog& owner, int itemI
 
         static std::regex s_formatString(R"(%L?(\d\d?|n))", std::regex_constants::ECMAScript | std::regex_constants::optimize);
         if (std::regex_search(sourceText, s_formatString))
-            m_moreFlags = ", qt-format";
+            m_moreFlags = StringPool::Wrap(", qt-format");
     }
 
     auto numerus = node.attribute("numerus").value();
@@ -105,12 +105,6 @@ QtLinguistCatalogItem::QtLinguistCatalogItem(QtLinguistCatalog& owner, int itemI
         SetPluralString(m_string);
     }
 
-    auto oldsource = node.child("oldsource");
-    if (oldsource)
-    {
-        m_oldMsgid.push_back(str::to_wx(get_node_text(oldsource)));
-    }
-
     auto translation = node.child("translation");
     if (translation)
     {
@@ -150,18 +144,36 @@ QtLinguistCatalogItem::QtLinguistCatalogItem(QtLinguistCatalog& owner, int itemI
     if (comment)
         SetContext(str::to_wx(get_node_text(comment)));
 
+    auto translatorcomment = node.child("translatorcomment");
+    if (translatorcomment)
+    {
+        m_comment = StringPool::Wrap(AddStartHashToComment(str::to_wx(get_node_text(translatorcomment))));
+    }
+
+    // extracted comments and old source are read from the node when needed
+    SetHasDeferredData();
+}
+
+
+void QtLinguistCatalogItem::LoadDeferredData()
+{
+    document_lock lock(this);
+
     // Actual comments:
-    auto extracomment = node.child("extracomment");
+    auto extracomment = m_node.child("extracomment");
     if (extracomment)
     {
-        std::string commentText = get_node_text(extracomment);
-        m_extractedComments.push_back(str::to_wx(commentText));
+        wxArrayString comments;
+        comments.push_back(str::to_wx(get_node_text(extracomment)));
+        m_extractedComments = StringPool::Wrap(comments);
     }
 
-    auto translatorcomment = node.child("translatorcomment");
-    if (translatorcomment)
+    auto oldsource = m_node.child("oldsource");
+    if (oldsource)
     {
-        m_comment = AddStartHashToComment(str::to_wx(get_node_text(translatorcomment)));
+        wxArrayString old;
+        old.push_back(str::to_wx(get_node_text(oldsource)));
+        m_oldMsgid = StringPool::Wrap(old);
     }
 }
 
@@ -264,7 +276,7 @@ bool QtLinguistCatalog::CanLoadFile(const wxString& extension)
 std::shared_ptr<QtLinguistCatalog> QtLinguistCatalog::Open(const wxString& filename)
 {
     xml_document doc;
-    auto result = doc.load_file(filename.fn_str(), PUGI_PARSE_FLAGS);
+    auto result = load_file(doc, filename);
     if (!result)
         BOOST_THROW_EXCEPTION(QtLinguistReadException(result.description()));
 
@@ -315,7 +327,7 @@ void QtLinguistCatalog::ParseSubtree(int& id, pugi::xml_node root, [[maybe_unuse
             continue;
         }
 
-        m_items.push_back(std::make_shared<QtLinguistCatalogItem>(*this, ++id, message));
+        AppendItem(std::make_shared<QtLinguistCatalogItem>(*this, ++id, message));
     }
 }
 
@@ -349,12 +361,11 @@ bool QtLinguistCatalog::Save(const wxString& filename, bool /*save_mo*/,
 }
 
 
-std::string QtLinguistCatalog::SaveToBuffer()
+bool QtLinguistCatalog::SaveToStream(std::ostream& out)
 {
-    std::ostringstream s;
     // format_no_empty_element_tags (i.e. <translation></translation> is convention in .ts files
-    m_doc.save(s, "\t", format_raw | format_no_empty_element_tags);
-    return s.str();
+    m_doc.save(out, "\t", format_raw | format_no_empty_element_tags);
+    return out.good();
 }
 
 
@@ -63,6 +63,7 @@ public:
 
 protected:
     void UpdateInternalRepresentation() override;
+    void LoadDeferredData() override;
 
     struct document_lock : public std::lock_guard<std::mutex>
     {
@@ -92,7 +93,7 @@ public:
               ValidationResults& validation_results,
               CompilationStatus& mo_compilation_status) override;
 
-    std::string SaveToBuffer() override;
+    bool SaveToStream(std::ostream& out) override;
 
     Language GetLanguage() const override { return m_language; }
     void SetLanguage(Language lang) override;
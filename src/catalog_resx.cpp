@@ -103,7 +103,7 @@ RESXCatalogItem::RESXCatalogItem(RESXCatalog& owner, int itemId, xml_node node)
         auto commentText = get_node_text(comment);
         if (!commentText.empty())
         {
-            m_extractedComments.push_back(str::to_wx(commentText));
+            AddExtractedComments(str::to_wx(commentText));
         }
     }
 }
@@ -150,7 +150,7 @@ bool RESXCatalog::CanLoadFile(const wxString& extension)
 std::shared_ptr<RESXCatalog> RESXCatalog::Open(const wxString& filename)
 {
     xml_document doc;
-    auto result = doc.load_file(filename.fn_str(), PUGI_PARSE_FLAGS);
+    auto result = load_file(doc, filename);
     if (!result)
         BOOST_THROW_EXCEPTION(RESXReadException(result.description()));
 
@@ -184,7 +184,7 @@ void RESXCatalog::Parse(pugi::xml_node root)
         if (name.empty())
             continue;
             
-        m_items.push_back(std::make_shared<RESXCatalogItem>(*this, ++id, data));
+        AppendItem(std::make_shared<RESXCatalogItem>(*this, ++id, data));
     }
 }
 
@@ -217,11 +217,10 @@ bool RESXCatalog::Save(const wxString& filename, bool /*save_mo*/,
 }
 
 
-std::string RESXCatalog::SaveToBuffer()
+bool RESXCatalog::SaveToStream(std::ostream& out)
 {
-    std::ostringstream s;
-    m_doc.save(s, "\t", format_raw);
-    return s.str();
+    m_doc.save(out, "\t", format_raw);
+    return out.good();
 }
 
 
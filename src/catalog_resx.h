@@ -91,7 +91,7 @@ public:
               ValidationResults& validation_results,
               CompilationStatus& mo_compilation_status) override;
 
-    std::string SaveToBuffer() override;
+    bool SaveToStream(std::ostream& out) override;
 
     Language GetLanguage() const override { return m_language; }
     void SetLanguage(Language lang) override;
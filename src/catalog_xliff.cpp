@@ -144,6 +144,40 @@ inline bool is_numeric_only(const std::string& s)
     return std::all_of(s.begin(), s.end(), [](char c){ return c >= '0' && c <= '9'; });
 }
 
+/**
+    Visit all element descendants of @a root in document order.
+
+    This is a plain tree walk, much cheaper than XPath queries on large files.
+    @a visitor is called as `bool visitor(xml_node)` and returns whether the
+    walk should descend into the element's children.
+ */
+template<typename T>
+void for_each_descendant_element(xml_node root, T&& visitor)
+{
+    auto node = root.first_child();
+    while (node)
+    {
+        if (node.type() == node_element && visitor(node) && node.first_child())
+        {
+            node = node.first_child();
+            continue;
+        }
+
+        while (!node.next_sibling())
+        {
+            node = node.parent();
+            if (node == root)
+                return;
+        }
+        node = node.next_sibling();
+    }
+}
+
+inline bool is_element(xml_node node, const char *name)
+{
+    return strcmp(node.name(), name) == 0;
+}
+
 
 inline void xliff_prefix_id(std::string& id, xml_node node, const char *nameAttr)
 {
@@ -439,7 +473,7 @@ bool XLIFFCatalog::CanLoadFile(const wxString& extension)
 std::shared_ptr<XLIFFCatalog> XLIFFCatalog::OpenImpl(const wxString& filename, InstanceCreatorImpl& creator)
 {
     xml_document doc;
-    auto result = doc.load_file(filename.fn_str(), PUGI_PARSE_FLAGS);
+    auto result = load_file(doc, filename);
     if (!result)
         BOOST_THROW_EXCEPTION(XLIFFReadException(result.description()));
 
@@ -508,11 +542,10 @@ bool XLIFFCatalog::Save(const wxString& filename, bool /*save_mo*/,
 }
 
 
-std::string XLIFFCatalog::SaveToBuffer()
+bool XLIFFCatalog::SaveToStream(std::ostream& out)
 {
-    std::ostringstream s;
-    m_doc.save(s, "\t", format_raw);
-    return s.str();
+    m_doc.save(out, "\t", format_raw);
+    return out.good();
 }
 
 
@@ -534,7 +567,8 @@ std::string XLIFFCatalog::GetXPathValue(const char* xpath) const
 class XLIFF12CatalogItem : public XLIFFCatalogItem
 {
 public:
-    XLIFF12CatalogItem(XLIFF1Catalog& owner, int itemId, xml_node node) : XLIFFCatalogItem(owner, itemId, node)
+    XLIFF12CatalogItem(XLIFF1Catalog& owner, int itemId, xml_node node, std::vector<xml_node>&& annotations)
+        : XLIFFCatalogItem(owner, itemId, node), m_annotations(std::move(annotations))
     {
         auto source = node.child("source");
 
@@ -571,16 +605,8 @@ public:
             m_translations.push_back("");
         }
 
-        for (auto note: node.children("note"))
-        {
-            std::string noteText = note.text().get();
-            if (noteText == "No comment provided by engineer.")  // Xcode does that
-                continue;
-
-            if (!m_extractedComments.empty())
-                m_extractedComments.push_back("");
-            m_extractedComments.push_back(str::to_wx(noteText));
-        }
+        // notes are read from the node when needed
+        SetHasDeferredData();
 
         // Parse maxwidth/minwidth constraints per XLIFF 1.2 spec
         // https://docs.oasis-open.org/xliff/v1.2/os/xliff-core.html#maxwidth
@@ -590,6 +616,27 @@ public:
         ParseLengthConstraint(node.attribute("minwidth").value(), sizeUnit, m_string.length(), &m_minLength);
     }
 
+    void LoadDeferredData() override
+    {
+        document_lock lock(this);
+
+        wxArrayString comments;
+        for (auto note: m_annotations)
+        {
+            if (!is_element(note, "note"))
+                continue;
+
+            std::string noteText = note.text().get();
+            if (noteText == "No comment provided by engineer.")  // Xcode does that
+                continue;
+
+            if (!comments.empty())
+                comments.push_back("");
+            comments.push_back(str::to_wx(noteText));
+        }
+        m_extractedComments = StringPool::Wrap(comments);
+    }
+
     void UpdateInternalRepresentation() override
     {
         wxASSERT( m_translations.size() == 1 ); // no plurals
@@ -644,10 +691,13 @@ public:
     wxArrayString GetReferences() const override
     {
         wxArrayString refs;
-        for (auto loc: m_node.select_nodes(".//context-group[@purpose='location']"))
+        for (auto loc: m_annotations)
         {
+            if (!is_element(loc, "context-group"))
+                continue;
+
             wxString file, line;
-            for (auto ctxt: loc.node().children("context"))
+            for (auto ctxt: loc.children("context"))
             {
                 auto type = ctxt.attribute("context-type").value();
                 if (strcmp(type, "sourcefile") == 0)
@@ -687,6 +737,9 @@ private:
 
     int m_maxLength = 0;
     int m_minLength = 0;
+
+    // <trans-unit>'s <note> children and location <context-group>s, collected by Parse()
+    std::vector<xml_node> m_annotations;
 };
 
 
@@ -722,17 +775,41 @@ void XLIFF1Catalog::Parse(pugi::xml_node root)
             extractedLanguage = true;
         }
 
-        for (auto unit: file.select_nodes(".//trans-unit"))
+        // Single pass over the tree that collects units together with the nodes
+        // their items need later, so that no per-unit XPath queries are needed:
+        for_each_descendant_element(file, [this, &id](xml_node node)
         {
-            auto node = unit.node();
+            if (!is_element(node, "trans-unit"))
+                return !is_element(node, "header"); // descend into <body>, <group> etc.
+
             if (strcmp(node.attribute("translate").value(), "no") == 0)
-                continue;
+                return false;
+
+            std::vector<xml_node> annotations;
+            for_each_descendant_element(node, [node, &annotations](xml_node child)
+            {
+                if (is_element(child, "note"))
+                {
+                    if (child.parent() == node)
+                        annotations.push_back(child);
+                    return false;
+                }
+                if (is_element(child, "context-group"))
+                {
+                    if (strcmp(child.attribute("purpose").value(), "location") == 0)
+                        annotations.push_back(child);
+                    return false;
+                }
+                // source and target texts only contain inline markup, nothing of interest
+                return !is_element(child, "source") && !is_element(child, "seg-source") && !is_element(child, "target");
+            });
 
             if (m_subversion == 0)
-                m_items.push_back(std::make_shared<XLIFF10CatalogItem>(*this, ++id, node));
+                AppendItem(std::make_shared<XLIFF10CatalogItem>(*this, ++id, node, std::move(annotations)));
             else
-                m_items.push_back(std::make_shared<XLIFF12CatalogItem>(*this, ++id, node));
-        }
+                AppendItem(std::make_shared<XLIFF12CatalogItem>(*this, ++id, node, std::move(annotations)));
+            return false;
+        });
     }
 }
 
@@ -754,7 +831,8 @@ void XLIFF1Catalog::SetLanguage(Language lang)
 class XLIFF2CatalogItem : public XLIFFCatalogItem
 {
 public:
-    XLIFF2CatalogItem(XLIFF2Catalog& owner, int itemId, xml_node node) : XLIFFCatalogItem(owner, itemId, node)
+    XLIFF2CatalogItem(XLIFF2Catalog& owner, int itemId, xml_node node, std::vector<xml_node> notes)
+        : XLIFFCatalogItem(owner, itemId, node), m_notes(std::move(notes))
     {
         auto source = node.child("source");
 
@@ -790,14 +868,27 @@ public:
         std::string substate = node.attribute("subState").value();
         m_isFuzzy = (m_isTranslated && state == "initial") || (substate == "poedit:fuzzy");
 
-        for (auto note: unit().select_nodes(".//note[not(@category='location')]"))
+        // notes are read from the unit when needed
+        SetHasDeferredData();
+    }
+
+    void LoadDeferredData() override
+    {
+        document_lock lock(this);
+
+        wxArrayString comments;
+        for (auto note: m_notes)
         {
-            std::string noteText = note.node().text().get();
+            if (strcmp(note.attribute("category").value(), "location") == 0)
+                continue;
 
-            if (!m_extractedComments.empty())
-                m_extractedComments.push_back("");
-            m_extractedComments.push_back(str::to_wx(noteText));
+            std::string noteText = note.text().get();
+
+            if (!comments.empty())
+                comments.push_back("");
+            comments.push_back(str::to_wx(noteText));
         }
+        m_extractedComments = StringPool::Wrap(comments);
     }
 
     void UpdateInternalRepresentation() override
@@ -847,9 +938,10 @@ public:
     wxArrayString GetReferences() const override
     {
         wxArrayString refs;
-        for (auto note: unit().select_nodes(".//note[@category='location']"))
+        for (auto note: m_notes)
         {
-            refs.push_back(str::to_wx(note.node().text().get()));
+            if (strcmp(note.attribute("category").value(), "location") == 0)
+                refs.push_back(str::to_wx(note.text().get()));
         }
         return refs;
     }
@@ -857,6 +949,9 @@ public:
 
 protected:
     xml_node unit() const { return m_node.parent(); }
+
+    // all <note> elements of the parent <unit>, collected by Parse()
+    std::vector<xml_node> m_notes;
 };
 
 
@@ -866,14 +961,40 @@ void XLIFF2Catalog::Parse(pugi::xml_node root)
     m_language = Language::FromLanguageTag(root.attribute("trgLang").value());
 
     int id = 0;
-    for (auto segment: root.select_nodes(".//segment"))
+
+    // Single pass over the tree that collects units' segments together with
+    // their notes, so that no per-unit XPath queries are needed:
+    std::vector<xml_node> segments, notes;
+    for_each_descendant_element(root, [&](xml_node node)
     {
-        auto node = segment.node();
-        if (strcmp(node.parent().attribute("translate").value(), "no") == 0)
-            continue;
+        if (!is_element(node, "unit"))
+            return true; // descend into <file>, <group> etc.
 
-        m_items.push_back(std::make_shared<XLIFF2CatalogItem>(*this, ++id, node));
-    }
+        if (strcmp(node.attribute("translate").value(), "no") == 0)
+            return false;
+
+        segments.clear();
+        notes.clear();
+        for_each_descendant_element(node, [&](xml_node child)
+        {
+            if (is_element(child, "segment"))
+            {
+                segments.push_back(child);
+                return false;
+            }
+            if (is_element(child, "note"))
+            {
+                notes.push_back(child);
+                return false;
+            }
+            // <ignorable> and <originalData> have nothing of interest in them
+            return !is_element(child, "ignorable") && !is_element(child, "originalData");
+        });
+
+        for (auto segment: segments)
+            AppendItem(std::make_shared<XLIFF2CatalogItem>(*this, ++id, segment, notes));
+        return false;
+    });
 }
 
 
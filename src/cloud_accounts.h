@@ -160,8 +160,9 @@ public:
         Asynchronously upload a file.
 
         The file is stored in a memory buffer and the destination information is provided by ExtractSyncMetadata().
+        The buffer is sent without making copies of it, pass it with std::move() if possible.
      */
-    virtual dispatch::future<void> UploadFile(const std::string& file_buffer, std::shared_ptr<FileSyncMetadata> meta) = 0;
+    virtual dispatch::future<void> UploadFile(std::string file_buffer, std::shared_ptr<FileSyncMetadata> meta) = 0;
 
 protected:
     CloudAccountClient() {}
@@ -71,9 +71,14 @@
     #endif
 #endif
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <type_traits>
 
 #include <wx/app.h>
@@ -653,6 +658,112 @@ inline auto on_main(F&& f) -> future<typename detail::future_unwrapper<typename
 
 
 
+namespace detail
+{
+
+struct parallel_for_state
+{
+    size_t count = 0;
+    size_t chunk = 1;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+
+    // type-erased caller's functor, called for a range of indexes:
+    void (*invoke)(void *func, size_t begin, size_t end) = nullptr;
+    void *func = nullptr;
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;  // written only by the thread that set failed
+
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    void run()
+    {
+        for (;;)
+        {
+            const size_t begin = next.fetch_add(chunk);
+            if (begin >= count)
+                return;  // nothing left, don't touch func, the caller may be gone already
+            const size_t end = std::min(begin + chunk, count);
+
+            try
+            {
+                invoke(func, begin, end);
+            }
+            catch (...)
+            {
+                if (!failed.exchange(true))
+                    error = std::current_exception();
+            }
+
+            if (done.fetch_add(end - begin) + (end - begin) == count)
+            {
+                // lock only to not lose the wakeup between waiter's check and wait:
+                std::lock_guard lock(mutex);
+                cv.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+
+/**
+    Calls f(i) for every i in [0, count) in parallel and waits for completion.
+
+    The work is distributed to background queue workers, but the calling thread
+    participates in it too and never waits for workers that didn't get to run,
+    so this is safe to call from background tasks as well. Indexes are handed
+    out in contiguous ranges, so that cheap calls aren't dominated by overhead.
+
+    If any of the calls throws, the first exception is rethrown; the remaining
+    indexes of the range it was thrown in are skipped.
+ */
+template<typename F>
+inline void parallel_for(size_t count, F&& f)
+{
+    if (count == 0)
+        return;
+    if (count == 1)
+    {
+        f(0);
+        return;
+    }
+
+    typedef typename std::remove_reference<F>::type func_type;
+
+    const size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+    const size_t threads = std::min(count, cores);
+
+    auto state = std::make_shared<detail::parallel_for_state>();
+    state->count = count;
+    // several ranges per thread, so that uneven work still balances:
+    state->chunk = std::max(count / (threads * 8), size_t(1));
+    state->func = const_cast<void*>(static_cast<const void*>(&f));
+    state->invoke = [](void *func, size_t begin, size_t end)
+    {
+        auto& fn = *static_cast<func_type*>(func);
+        for (size_t i = begin; i < end; ++i)
+            fn(i);
+    };
+
+    for (size_t i = 0; i < threads - 1; i++)
+        async([state]{ state->run(); });
+
+    state->run();
+
+    if (state->done.load() != count)
+    {
+        std::unique_lock lock(state->mutex);
+        state->cv.wait(lock, [&]{ return state->done.load() == count; });
+    }
+    if (state->failed.load())
+        std::rethrow_exception(state->error);
+}
+
+
 /// Helper exception for when the task was cancelled via cancellation_token
 class cancellation_exception : public std::exception
 {
@@ -653,7 +653,7 @@ dispatch::future<void> CrowdinClient::DownloadFile(const std::wstring& output_fi
 }
 
 
-dispatch::future<void> CrowdinClient::UploadFile(const std::string& file_buffer, std::shared_ptr<CrowdinClient::FileSyncMetadata> meta_)
+dispatch::future<void> CrowdinClient::UploadFile(std::string file_buffer, std::shared_ptr<CrowdinClient::FileSyncMetadata> meta_)
 {
     auto meta = std::dynamic_pointer_cast<CrowdinSyncMetadata>(meta_);
 
@@ -661,7 +661,7 @@ dispatch::future<void> CrowdinClient::UploadFile(const std::string& file_buffer,
 
     return m_api->post(
             "storages",
-            octet_stream_data(file_buffer),
+            octet_stream_data(std::move(file_buffer)),
             { { "Crowdin-API-FileName", "crowdin." + meta->extension } }
         )
         .then([this, meta] (json r) {
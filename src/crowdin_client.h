@@ -93,7 +93,7 @@ public:
     dispatch::future<void> DownloadFile(const std::wstring& output_file, std::shared_ptr<FileSyncMetadata> meta) override;
 
     /// Asynchronously upload specific Crowdin file data.
-    dispatch::future<void> UploadFile(const std::string& file_buffer, std::shared_ptr<FileSyncMetadata> meta) override;
+    dispatch::future<void> UploadFile(std::string file_buffer, std::shared_ptr<FileSyncMetadata> meta) override;
 
 private:
     class crowdin_http_client;
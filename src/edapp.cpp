@@ -78,6 +78,7 @@
 #endif
 
 #include "app_updates.h"
+#include "batch.h"
 #include "colorscheme.h"
 #include "concurrency.h"
 #include "configuration.h"
@@ -101,6 +102,7 @@
 #include "recent_files.h"
 #include "str_helpers.h"
 #include "tm/transmem.h"
+#include "tm/tm_server.h"
 #include "utility.h"
 #include "prefsdlg.h"
 #include "errors.h"
@@ -323,6 +325,12 @@ static wxArrayString gs_filesToOpen;
 #endif
 static int gs_lineToOpen = 0;
 static wxString gs_uriToHandle;
+static bool gs_headless = false;
+static bool gs_batchMode = false;
+static BatchOptions gs_batchOptions;
+static std::vector<wxString> gs_batchFiles;
+static int gs_batchExitCode = 0;
+static long gs_tmServerPort = 0;
 
 extern void InitXmlResource();
 
@@ -366,13 +374,15 @@ bool PoeditApp::OnInit()
 #endif
 
 #ifndef __WXOSX__
-    m_remoteServer.reset(new RemoteServer(this));
+    if (!gs_headless)
+        m_remoteServer.reset(new RemoteServer(this));
 #endif
 
     InitHiDPIHandling();
 
 #ifdef __WXOSX__
-    PFMoveToApplicationsFolderIfNecessary();
+    if (!gs_headless)
+        PFMoveToApplicationsFolderIfNecessary();
 
     wxSystemOptions::SetOption(wxMAC_TEXTCONTROL_USE_SPELL_CHECKER, 1);
 
@@ -446,6 +456,46 @@ bool PoeditApp::OnInit()
 
     SetupLanguage();
 
+    if (gs_batchMode)
+    {
+        // Headless processing: no windows are created and the event loop only
+        // runs to service background tasks until the batch is finished.
+        delete wxLog::SetActiveTarget(new wxLogStderr);
+
+        // wxConfig is only read here, on the main thread, not by the workers:
+        gs_batchOptions.pretranslateSettings = Config::PretranslateSettings();
+
+        dispatch::async([]{
+            return RunBatchProcessing(gs_batchFiles, gs_batchOptions);
+        })
+        .then_on_main([this](int exitCode){
+            gs_batchExitCode = exitCode;
+            ExitMainLoop();
+        })
+        .catch_all([this](dispatch::exception_ptr e){
+            wxLogError("%s", DescribeException(e));
+            gs_batchExitCode = 1;
+            ExitMainLoop();
+        });
+        return true;
+    }
+
+    if (gs_tmServerPort)
+    {
+        // Headless TM server, running until killed or asked to shut down
+        delete wxLog::SetActiveTarget(new wxLogStderr);
+        try
+        {
+            m_tmServer.reset(new TranslationMemoryServer((unsigned short)gs_tmServerPort, [this]{ ExitMainLoop(); }));
+        }
+        catch (...)
+        {
+            wxLogError("%s", DescribeCurrentException());
+            return false;
+        }
+        return true;
+    }
+
 #ifdef __WXOSX__
     CreateMenu(Menu::Global);
     // so that help menu is correctly merged with system-provided menu
@@ -493,6 +543,12 @@ bool PoeditApp::OnInit()
     return true;
 }
 
+int PoeditApp::OnRun()
+{
+    int retval = wxApp::OnRun();
+    return gs_batchMode ? gs_batchExitCode : retval;
+}
+
 void PoeditApp::OnEventLoopEnter(wxEventLoopBase *loop)
 {
     wxApp::OnEventLoopEnter(loop);
@@ -517,6 +573,9 @@ int PoeditApp::OnExit()
     // early -- e.g. before wxConfig is destroyed, so they can save changes
     DeletePendingObjects();
 
+    // must be stopped before the TM is destroyed below:
+    m_tmServer.reset();
+
     FileMonitor::CleanUp();
     ColorScheme::CleanUp();
     RecentFiles::CleanUp();
@@ -684,19 +743,19 @@ wxLayoutDirection PoeditApp::GetLayoutDirection() const
 
 wxString PoeditApp::GetCacheDir(const wxString& category)
 {
-    static wxString localBaseDir;
-
-    if (localBaseDir.empty())
+    // initialized on first use in a thread-safe way, this is called from worker threads too:
+    static const wxString localBaseDir = []
     {
-        localBaseDir = wxStandardPaths::Get().GetUserDir(wxStandardPaths::Dir_Cache);
+        wxString dir = wxStandardPaths::Get().GetUserDir(wxStandardPaths::Dir_Cache);
     #if defined(__WXOSX__)
-        localBaseDir += "/net.poedit.Poedit";
+        dir += "/net.poedit.Poedit";
     #elif defined(__WXMSW__)
-        localBaseDir += "\\Poedit\\Cache";
+        dir += "\\Poedit\\Cache";
     #else
-        localBaseDir += "/poedit";
+        dir += "/poedit";
     #endif
-    }
+        return dir;
+    }();
 
     return localBaseDir + wxFILE_SEP_PATH + category;
 }
@@ -764,6 +823,14 @@ namespace
 const char *CL_KEEP_TEMP_FILES = "keep-temp-files";
 const char *CL_HANDLE_POEDIT_URI = "handle-poedit-uri";
 const char *CL_LINE = "line";
+const char *CL_BATCH = "batch";
+const char *CL_BATCH_UPDATE = "update";
+const char *CL_BATCH_PRETRANSLATE = "pretranslate";
+const char *CL_BATCH_VALIDATE = "validate";
+const char *CL_BATCH_COMPILE = "compile";
+const char *CL_BATCH_FIX_DUPLICATES = "fix-duplicates";
+const char *CL_BATCH_JOBS = "jobs";
+const char *CL_TM_SERVER = "tm-server";
 }
 
 void PoeditApp::OnInitCmdLine(wxCmdLineParser& parser)
@@ -776,6 +843,22 @@ void PoeditApp::OnInitCmdLine(wxCmdLineParser& parser)
                      _("handle a poedit:// URI"), wxCMD_LINE_VAL_STRING);
     parser.AddLongOption(CL_LINE,
                      _("go to item at given line number"), wxCMD_LINE_VAL_NUMBER);
+    parser.AddSwitch("", CL_BATCH,
+                     _("process given files without user interface and exit"));
+    parser.AddSwitch("", CL_BATCH_UPDATE,
+                     _("batch mode: update from source code"));
+    parser.AddSwitch("", CL_BATCH_PRETRANSLATE,
+                     _("batch mode: pre-translate using translation memory"));
+    parser.AddSwitch("", CL_BATCH_VALIDATE,
+                     _("batch mode: check translations for errors"));
+    parser.AddSwitch("", CL_BATCH_COMPILE,
+                     _("batch mode: compile MO files"));
+    parser.AddSwitch("", CL_BATCH_FIX_DUPLICATES,
+                     _("batch mode: merge duplicate entries (PO only)"));
+    parser.AddLongOption(CL_BATCH_JOBS,
+                     _("batch mode: number of files processed in parallel"), wxCMD_LINE_VAL_NUMBER);
+    parser.AddLongOption(CL_TM_SERVER,
+                     _("serve translation memory queries on given local port"), wxCMD_LINE_VAL_NUMBER);
     parser.AddParam("translation.po", wxCMD_LINE_VAL_STRING,
                     wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE);
 }
@@ -792,6 +875,49 @@ bool PoeditApp::OnCmdLineParsed(wxCmdLineParser& parser)
     if ( parser.Found(CL_KEEP_TEMP_FILES) )
         TempDirectory::KeepFiles();
 
+    if (parser.Found(CL_TM_SERVER, &gs_tmServerPort))
+    {
+        if (gs_tmServerPort <= 0 || gs_tmServerPort > 65535)
+        {
+            wxLogError(_("Invalid port number."));
+            wxLog::FlushActive();
+            return false;
+        }
+        gs_headless = true;
+        return true;
+    }
+
+    if (parser.Found(CL_BATCH))
+    {
+        gs_headless = true;
+        gs_batchMode = true;
+        gs_batchOptions.update = parser.Found(CL_BATCH_UPDATE);
+        gs_batchOptions.pretranslate = parser.Found(CL_BATCH_PRETRANSLATE);
+        gs_batchOptions.validate = parser.Found(CL_BATCH_VALIDATE);
+        gs_batchOptions.compile = parser.Found(CL_BATCH_COMPILE);
+        gs_batchOptions.fixDuplicates = parser.Found(CL_BATCH_FIX_DUPLICATES);
+        long jobs = 0;
+        if (parser.Found(CL_BATCH_JOBS, &jobs) && jobs > 0)
+            gs_batchOptions.jobs = (unsigned)jobs;
+
+        for (size_t i = 0; i < parser.GetParamCount(); i++)
+        {
+            wxFileName fn(parser.GetParam(i));
+            fn.MakeAbsolute();
+            gs_batchFiles.push_back(fn.GetFullPath());
+        }
+
+        if (gs_batchFiles.empty())
+        {
+            wxLogError(_("No files to process were given."));
+            wxLog::FlushActive();
+            return false;
+        }
+
+        // don't talk to other running instances, the batch runs independently
+        return true;
+    }
+
 #ifndef __WXOSX__
     RemoteClient client(m_instanceChecker.get());
     switch (client.ConnectIfNeeded())
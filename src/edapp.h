@@ -39,6 +39,7 @@
 class Language;
 class WXDLLIMPEXP_FWD_BASE wxConfigBase;
 class WXDLLIMPEXP_FWD_BASE wxSingleInstanceChecker;
+class TranslationMemoryServer;
 
 #if defined(HAVE_HTTP_CLIENT) && (defined(__WXMSW__) || defined(__WXOSX__) || defined(SNAPCRAFT))
     #define SUPPORTS_OTA_UPDATES
@@ -55,6 +56,7 @@ class PoeditApp : public wxApp, public MenusManager
             configuration entries to default values if they were missing.
          */
         bool OnInit() override;
+        int OnRun() override;
         void OnEventLoopEnter(wxEventLoopBase *loop) override;
         int OnExit() override;
 
@@ -137,6 +139,7 @@ class PoeditApp : public wxApp, public MenusManager
 
         std::unique_ptr<PoeditPreferencesEditor> m_preferences;
         std::unique_ptr<wxLocale> m_locale;
+        std::unique_ptr<TranslationMemoryServer> m_tmServer;
 
 #ifndef __WXOSX__
         class RemoteServer;
@@ -756,6 +756,9 @@ PoeditFrame::~PoeditFrame()
     // write all changes:
     cfg->Flush();
 
+    // the window is closed normally, so any unsaved changes were deliberately discarded:
+    m_journal.Discard();
+
     m_catalog.reset();
     m_pendingHumanEditedItem.reset();
     m_navigationHistory.clear();
@@ -1344,6 +1347,7 @@ void PoeditFrame::NewFromPOT(POCatalogPtr pot, Language language)
     m_catalog = catalog;
     m_pendingHumanEditedItem.reset();
     m_navigationHistory.clear();
+    m_journal.Discard();
 
     m_fileExistsOnDisk = false;
     m_modified = true;
@@ -1414,6 +1418,7 @@ void PoeditFrame::NewFromScratch()
     m_catalog = catalog;
     m_pendingHumanEditedItem.reset();
     m_navigationHistory.clear();
+    m_journal.Discard();
 
     m_fileExistsOnDisk = false;
     m_modified = true;
@@ -1478,6 +1483,7 @@ void PoeditFrame::EditCatalogProperties()
                     return;
 
                 dlg->TransferFrom(m_catalog);
+                m_journal.RecordHeader(*m_catalog);
                 m_modified = true;
                 UpdateEditingUIAfterChange();
                 UpdateTitle();
@@ -1510,6 +1516,7 @@ void PoeditFrame::EditCatalogProperties()
                 if (dlg->GetLang() != m_catalog->GetLanguage())
                 {
                     m_catalog->SetLanguage(dlg->GetLang());
+                    m_journal.Suspend();  // language isn't in header for these formats
                     m_modified = true;
                     UpdateEditingUIAfterChange();
 
@@ -1536,6 +1543,7 @@ void PoeditFrame::EditCatalogPropertiesAndUpdateFromSources()
         if (retcode == wxID_OK)
         {
             dlg->TransferFrom(m_catalog);
+            m_journal.RecordHeader(*m_catalog);
             m_modified = true;
             if (m_list)
                 UpdateEditingUIAfterChange();
@@ -1628,6 +1636,7 @@ void PoeditFrame::UpdateCatalog(const wxString& pot_file)
 
         m_catalog = updated_catalog;
         m_modified = true;
+        m_journal.Suspend();  // items were restructured, can't be replayed until saved
 
         EnsureAppropriateContentView();
         NotifyCatalogChanged(m_catalog);
@@ -1635,10 +1644,11 @@ void PoeditFrame::UpdateCatalog(const wxString& pot_file)
 
         if (Config::UseTM() && Config::MergeBehavior() == Merge_UseTM)
         {
-            PreTranslateCatalogAuto(this, m_catalog, PreTranslateOptions(PreTranslate_OnlyGoodQuality), [=]
+            PreTranslateCatalogAuto(this, m_list, m_catalog, PreTranslateOptions(PreTranslate_OnlyGoodQuality), [=]
             {
                 RefreshControls();
-            });
+            },
+            [=]{ UpdateStatusBar(); });
         }
 
         // locker gets released now and the list is redrawn
@@ -1707,9 +1717,14 @@ void PoeditFrame::OnUpdateFromPOTUpdate(wxUpdateUIEvent& event)
             event.SetText(MSW_OR_OTHER(_(L"Update from &POT file…"), _(L"Update from &POT File…")));
             break;
 
-        default:
+        case Catalog::Type::XCLOC:
             event.Enable(false);
             break;
+
+        default:
+            // other formats are merged with MergeCatalogWithReferenceNative()
+            event.SetText(MSW_OR_OTHER(_(L"Update from &reference file…"), _(L"Update from &Reference File…")));
+            break;
     };
 }
 
@@ -2035,6 +2050,7 @@ void PoeditFrame::OnFuzzyFlag(wxCommandEvent&)
         {
             item.SetFuzzy(setFuzzy);
             item.SetModified(true);
+            m_journal.RecordItem(item);
             modified = true;
         }
     });
@@ -2085,8 +2101,9 @@ void PoeditFrame::OnCopyFromSource(wxCommandEvent&)
 {
     bool modified = false;
 
-    m_list->ForSelectedCatalogItemsDo([&modified](CatalogItem& item){
+    m_list->ForSelectedCatalogItemsDo([this,&modified](CatalogItem& item){
         item.SetTranslationFromSource();
+        m_journal.RecordItem(item);
         if (item.IsModified())
             modified = true;
     });
@@ -2105,8 +2122,9 @@ void PoeditFrame::OnClearTranslation(wxCommandEvent&)
 {
     bool modified = false;
 
-    m_list->ForSelectedCatalogItemsDo([&modified](CatalogItem& item){
+    m_list->ForSelectedCatalogItemsDo([this,&modified](CatalogItem& item){
         item.ClearTranslation();
+        m_journal.RecordItem(item);
         if (item.IsModified())
             modified = true;
     });
@@ -2170,6 +2188,7 @@ void PoeditFrame::OnUpdatedFromTextCtrl(CatalogItemPtr item, bool statsChanged)
 
     m_pendingHumanEditedItem = item;
     RecordItemToNavigationHistory(item);
+    m_journal.RecordItem(*item);
 
     if (statsChanged)
     {
@@ -2265,6 +2284,7 @@ void PoeditFrame::ReadCatalog(const CatalogPtr& cat)
         // causing crash in UpdateToTextCtrl() called from
         // UpdateEditingUIAfterChange() just few lines below.
         NotifyCatalogChanged(m_catalog);
+        m_journal.Discard();  // of the previously open file
 
         m_fileExistsOnDisk = true;
         m_modified = false;
@@ -2294,6 +2314,7 @@ void PoeditFrame::ReadCatalog(const CatalogPtr& cat)
     UpdateCloudSyncUI(CanSyncWithCrowdin(m_catalog));
 #endif
 
+    OfferRecoveryOfUnsavedChanges();
     FixDuplicatesIfPresent();
 }
 
@@ -2319,6 +2340,7 @@ void PoeditFrame::FixDuplicatesIfPresent()
     // Fix duplicates and explain the changes to the user:
     cat->FixDuplicateItems();
     NotifyCatalogChanged(m_catalog);
+    m_journal.Suspend();
 
     wxWindowPtr<wxMessageDialog> dlg(
         new wxMessageDialog
@@ -2334,6 +2356,47 @@ void PoeditFrame::FixDuplicatesIfPresent()
 
 }
 
+void PoeditFrame::OfferRecoveryOfUnsavedChanges()
+{
+    const wxString filename = m_catalog->GetFileName();
+    if (!EditJournal::HasUnsavedChanges(filename))
+    {
+        m_journal.Start(filename);
+        return;
+    }
+
+    wxWindowPtr<wxMessageDialog> dlg(
+        new wxMessageDialog
+            (
+                this,
+                wxString::Format(_(L"Recover unsaved changes to the file “%s”?"), wxFileName(filename).GetFullName()),
+                _("Unsaved changes"),
+                wxYES_NO | wxICON_QUESTION
+            )
+    );
+    dlg->SetExtendedMessage(_(L"Poedit wasn’t closed properly while you were editing this file. Changes made since it was last saved can be restored."));
+    dlg->SetYesNoLabels(_("Recover"), _("Discard"));
+
+    dlg->ShowWindowModalThenDo([this,dlg,filename](int retcode){
+        if (!m_catalog || m_catalog->GetFileName() != filename)
+            return;
+        if (retcode == wxID_YES)
+        {
+            if (m_journal.Recover(*m_catalog) > 0)
+            {
+                m_modified = true;
+                UpdateTitle();
+                RefreshControls();
+                UpdateToTextCtrl(EditingArea::ItemChanged);
+            }
+        }
+        else
+        {
+            m_journal.Start(filename);
+        }
+    });
+}
+
 void PoeditFrame::WarnAboutLanguageIssues()
 {
     Language srclang = m_catalog->GetSourceLanguage();
@@ -2843,6 +2906,7 @@ void PoeditFrame::WriteCatalog(const wxString& catalog, TFunctor completionHandl
     m_catalog->SetFileName(catalog);
     m_modified = false;
     m_fileExistsOnDisk = true;
+    m_journal.Start(m_catalog->GetFileName());
     m_fileMonitor->SetFile(m_catalog->GetFileName());
 
     UpdateTitle();
@@ -2909,11 +2973,12 @@ void PoeditFrame::OnEditComment(wxCommandEvent& event)
             wxString comment = dlg->GetComment();
 
             bool modified = false;
-            m_list->ForSelectedCatalogItemsDo([&modified,comment](CatalogItem& item){
+            m_list->ForSelectedCatalogItemsDo([this,&modified,comment](CatalogItem& item){
                 if (item.GetComment() != comment)
                 {
                     item.SetComment(comment);
                     item.SetModified(true);
+                    m_journal.RecordItem(item);
                     modified = true;
                 }
             });
@@ -2949,6 +3014,7 @@ void PoeditFrame::OnRemoveSameAsSourceTranslations(wxCommandEvent&)
             wxBusyCursor bcur;
             if (m_catalog->RemoveSameAsSourceTranslations())
             {
+                m_journal.RecordChangedItems(*m_catalog);
                 m_modified = true;
                 RefreshControls();
             }
@@ -2973,6 +3039,7 @@ void PoeditFrame::OnPurgeDeleted(wxCommandEvent& WXUNUSED(event))
     dlg->ShowWindowModalThenDo([this,dlg](int retcode){
         if (retcode == wxID_YES) {
             m_catalog->RemoveDeletedItems();
+            m_journal.Suspend();
             m_modified = true;
             UpdateTitle();
             UpdateMenu();
@@ -2990,6 +3057,7 @@ void PoeditFrame::OnSuggestion(wxCommandEvent& event)
     entry->SetTranslation(event.GetString());
     entry->SetFuzzy(false);
     entry->SetModified(true);
+    m_journal.RecordItem(*entry);
 
     // FIXME: instead of this mess, use notifications of catalog change
     m_modified = true;
@@ -3005,13 +3073,15 @@ void PoeditFrame::OnSuggestion(wxCommandEvent& event)
 void PoeditFrame::OnPreTranslateAll(wxCommandEvent&)
 {
     PreTranslateWithUI(this, m_list, m_catalog,[=]{
+        m_journal.RecordChangedItems(*m_catalog);
         if (!m_modified)
         {
             m_modified = true;
             UpdateTitle();
         }
         RefreshControls();
-    });
+    },
+    [=]{ UpdateStatusBar(); });
 }
 
 
@@ -3492,6 +3562,7 @@ void PoeditFrame::OnDoneAndNext(wxCommandEvent&)
         item->SetFuzzy(false);
         item->SetPreTranslated(false);
         item->SetModified(true);
+        m_journal.RecordItem(*item);
         if (!IsModified())
         {
             m_modified = true;
@@ -42,6 +42,7 @@ class WXDLLIMPEXP_FWD_CORE wxSplitterEvent;
 #include "gexecute.h"
 #include "edlistctrl.h"
 #include "edapp.h"
+#include "edit_journal.h"
 #include "filemonitor.h"
 
 #ifdef __WXMSW__
@@ -118,6 +119,7 @@ class PoeditFrame : public PoeditFrameBase
         void WriteCatalog(const wxString& catalog, TFunctor completionHandler);
 
         void FixDuplicatesIfPresent();
+        void OfferRecoveryOfUnsavedChanges();
         void WarnAboutLanguageIssues();
         void SideloadSourceTextFromFile(const wxFileName& fn);
         void OfferSideloadingSourceText();
@@ -127,6 +129,9 @@ class PoeditFrame : public PoeditFrameBase
 
         void MarkAsModified();
 
+        /// Records a change to the item made outside of the frame (for crash recovery).
+        void JournalItemChange(const CatalogItem& item) { m_journal.RecordItem(item); }
+
         /** Updates catalog and sets m_modified flag. Updates from POT
             if \a pot_file is not empty and from sources otherwise.
          */
@@ -369,6 +374,9 @@ private:
         CatalogItemPtr m_pendingHumanEditedItem;
         std::vector<CatalogItemPtr> m_navigationHistory;
 
+        // log of unsaved changes, for recovery after a crash
+        EditJournal m_journal;
+
         EditingArea *m_editingArea;
         wxSplitterWindow *m_splitter;
         wxSplitterWindow *m_sidebarSplitter;
@@ -0,0 +1,371 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "edit_journal.h"
+
+#include "edapp.h"
+#include "json.h"
+#include "utility.h"
+
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace
+{
+
+const int JOURNAL_VERSION = 1;
+
+// FNV-1a, because the hashes must be stable between sessions
+uint64_t HashString(const std::string& s)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c: s)
+    {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t GetItemKey(const CatalogItem& item)
+{
+    std::string key;
+    if (item.HasContext())
+    {
+        key = item.GetContext().utf8_string();
+        key += '\x04';
+    }
+    key += item.GetRawString().utf8_string();
+    return HashString(key);
+}
+
+inline long long GetModTimeValue(const wxDateTime& dt)
+{
+    return dt.IsValid() ? dt.GetValue().GetValue() : 0;
+}
+
+/// Reads records from the journal if it exists and applies to the current version of the file
+bool ReadJournal(const wxString& path, const wxString& filename, std::vector<json>& records)
+{
+    if (!wxFileExists(path))
+        return false;
+
+    std::string data;
+    {
+        wxLogNull null;
+        wxFile f(path);
+        if (!f.IsOpened())
+            return false;
+        data.resize((size_t)f.Length());
+        if (f.Read(&data[0], data.size()) != (ssize_t)data.size())
+            return false;
+    }
+
+    wxFileName fn(filename);
+    bool baseOk = false;
+    std::string_view s(data);
+    while (!s.empty())
+    {
+        auto eol = s.find('\n');
+        if (eol == std::string_view::npos)
+            break;  // incomplete last record, written while crashing
+        auto line = s.substr(0, eol);
+        s.remove_prefix(eol + 1);
+
+        auto j = json::parse(line.begin(), line.end(), nullptr, /*allow_exceptions=*/false);
+        if (j.is_discarded() || !j.is_object())
+            continue;
+
+        if (!baseOk)
+        {
+            // the first line identifies the file the journal applies to:
+            try
+            {
+                baseOk = j.at("journal").get<int>() == JOURNAL_VERSION &&
+                         j.at("size").get<unsigned long long>() == fn.GetSize().GetValue() &&
+                         j.at("mtime").get<long long>() == GetModTimeValue(fn.GetModificationTime());
+            }
+            catch (const std::exception&)
+            {
+                baseOk = false;
+            }
+            if (!baseOk)
+                return false;
+            continue;
+        }
+
+        records.push_back(std::move(j));
+    }
+
+    return baseOk && !records.empty();
+}
+
+} // anonymous namespace
+
+
+wxString EditJournal::GetJournalPath(const wxString& filename)
+{
+    wxFileName fn(filename);
+    fn.MakeAbsolute();
+    auto hash = HashString(fn.GetFullPath().utf8_string());
+    return PoeditApp::GetCacheDir("Journals") + wxFILE_SEP_PATH + wxString::Format("%016llx.journal", (unsigned long long)hash);
+}
+
+
+void EditJournal::Start(const wxString& filename)
+{
+    Discard();
+
+    wxFileName fn(filename);
+    if (filename.empty() || !fn.FileExists())
+        return;
+
+    m_filename = filename;
+    m_path = GetJournalPath(filename);
+    m_fileSize = fn.GetSize();
+    m_fileModTime = fn.GetModificationTime();
+    m_suspended = false;
+
+    // the file was just loaded or saved, any older journal is obsolete:
+    if (wxFileExists(m_path))
+        wxRemoveFile(m_path);
+}
+
+
+void EditJournal::Discard()
+{
+    Close();
+
+    if (!m_path.empty() && wxFileExists(m_path))
+        wxRemoveFile(m_path);
+
+    m_filename.clear();
+    m_path.clear();
+    m_suspended = false;
+}
+
+
+void EditJournal::Suspend()
+{
+    m_suspended = true;
+    Close();
+}
+
+
+void EditJournal::Close()
+{
+    if (m_file.IsOpened())
+        m_file.Close();
+}
+
+
+void EditJournal::Append(const std::string& record)
+{
+    if (!m_file.IsOpened())
+    {
+        wxLogNull null;
+        wxFileName::Mkdir(wxPathOnly(m_path), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+        if (!m_file.Create(m_path, /*overwrite=*/true))
+        {
+            wxLogTrace("poedit", "failed to create edit journal %s", m_path);
+            m_suspended = true;
+            return;
+        }
+
+        json base = {
+            {"journal", JOURNAL_VERSION},
+            {"file", m_filename.utf8_string()},
+            {"size", m_fileSize.GetValue()},
+            {"mtime", GetModTimeValue(m_fileModTime)}
+        };
+        auto line = base.dump();
+        line += '\n';
+        m_file.Write(line.data(), line.size());
+    }
+
+    // wxFile is unbuffered, so each record reaches the OS immediately and
+    // survives the app crashing, without the cost of syncing to disk
+    std::string line(record);
+    line += '\n';
+    if (m_file.Write(line.data(), line.size()) != line.size())
+    {
+        wxLogTrace("poedit", "failed to write to edit journal %s", m_path);
+        Suspend();
+    }
+}
+
+
+void EditJournal::RecordItem(const CatalogItem& item)
+{
+    if (!IsActive())
+        return;
+
+    auto translations = json::array();
+    for (auto& t: item.GetTranslations())
+        translations.push_back(t.utf8_string());
+
+    json record = {
+        {"id", item.GetId()},
+        {"key", GetItemKey(item)},
+        {"translations", std::move(translations)},
+        {"fuzzy", item.IsFuzzy()},
+        {"pretranslated", item.IsPreTranslated()},
+        {"comment", item.GetComment().utf8_string()}
+    };
+    Append(record.dump());
+}
+
+
+void EditJournal::RecordChangedItems(const Catalog& catalog)
+{
+    if (!IsActive())
+        return;
+
+    for (auto& item: catalog.items())
+    {
+        if (item->IsDirty())
+            RecordItem(*item);
+    }
+}
+
+
+void EditJournal::RecordHeader(Catalog& catalog)
+{
+    if (!IsActive())
+        return;
+
+    auto& header = catalog.Header();
+    json record = {
+        {"header", UnescapeCString(header.ToString()).utf8_string()},
+        {"header_comment", header.Comment.utf8_string()}
+    };
+    Append(record.dump());
+}
+
+
+bool EditJournal::HasUnsavedChanges(const wxString& filename)
+{
+    if (filename.empty())
+        return false;
+
+    const wxString path = GetJournalPath(filename);
+    std::vector<json> records;
+    if (ReadJournal(path, filename, records))
+        return true;
+
+    // a journal that doesn't apply to the file as it is now is useless:
+    if (wxFileExists(path))
+        wxRemoveFile(path);
+    return false;
+}
+
+
+int EditJournal::Recover(Catalog& catalog)
+{
+    const wxString filename = catalog.GetFileName();
+    const wxString path = GetJournalPath(filename);
+
+    std::vector<json> records;
+    if (!ReadJournal(path, filename, records))
+    {
+        Start(filename);
+        return 0;
+    }
+
+    auto& items = catalog.items();
+    std::unordered_map<uint64_t, CatalogItemPtr> itemsByKey;
+
+    auto findItem = [&](int id, uint64_t key) -> CatalogItemPtr
+    {
+        if (id > 0 && id <= (int)items.size())
+        {
+            auto& item = items[id - 1];
+            if (item->GetId() == id && GetItemKey(*item) == key)
+                return item;
+        }
+
+        // the catalog was changed since (e.g. fixed duplicates), fall back to lookup by key:
+        if (itemsByKey.empty())
+        {
+            for (auto& i: items)
+                itemsByKey.emplace(GetItemKey(*i), i);
+        }
+        auto i = itemsByKey.find(key);
+        return i != itemsByKey.end() ? i->second : nullptr;
+    };
+
+    std::set<int> recovered;
+    for (auto& r: records)
+    {
+        try
+        {
+            if (r.contains("header"))
+            {
+                auto& header = catalog.Header();
+                header.FromString(wxString::FromUTF8(r.at("header").get<std::string>()));
+                header.Comment = wxString::FromUTF8(r.at("header_comment").get<std::string>());
+                continue;
+            }
+
+            auto item = findItem(r.at("id").get<int>(), r.at("key").get<uint64_t>());
+            if (!item)
+                continue;
+
+            wxArrayString translations;
+            for (auto& t: r.at("translations"))
+                translations.push_back(wxString::FromUTF8(t.get<std::string>()));
+
+            item->SetTranslations(translations);
+            item->SetFuzzy(r.at("fuzzy").get<bool>());
+            item->SetPreTranslated(r.at("pretranslated").get<bool>());
+            item->SetComment(wxString::FromUTF8(r.at("comment").get<std::string>()));
+            item->SetModified(true);
+            recovered.insert(item->GetId());
+        }
+        catch (const std::exception&)
+        {
+            // ignore malformed records, there's nothing better to do with them
+        }
+    }
+
+    wxLogTrace("poedit", "recovered %d items from edit journal %s", (int)recovered.size(), path);
+
+    // keep appending to the existing journal, it still applies to the same saved file:
+    Close();
+    wxFileName fn(filename);
+    m_filename = filename;
+    m_path = path;
+    m_fileSize = fn.GetSize();
+    m_fileModTime = fn.GetModificationTime();
+    m_suspended = !m_file.Open(m_path, wxFile::write_append);
+
+    return (int)recovered.size();
+}
@@ -0,0 +1,117 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_edit_journal_h
+#define Poedit_edit_journal_h
+
+#include "catalog.h"
+
+#include <wx/datetime.h>
+#include <wx/file.h>
+#include <wx/longlong.h>
+#include <wx/string.h>
+
+
+/**
+    Append-only log of changes made to a catalog since it was last saved.
+
+    Every change to an item is appended to a small journal file as soon as
+    it's made, so that unsaved work can be recovered if Poedit crashes or is
+    killed before the catalog is saved. This is much cheaper than saving the
+    whole catalog periodically: each change costs one short write.
+
+    The journal is kept in the user's cache directory and is specific to the
+    saved file it applies to. The first line identifies that file (by its
+    size and modification time), each following line is a JSON record with
+    the state of a changed item or of the header. Items are identified by
+    their ID, verified with a hash of their source text and context.
+ */
+class EditJournal
+{
+public:
+    EditJournal() {}
+    ~EditJournal() { Close(); }
+
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    /**
+        Starts journaling changes to catalog saved in @a filename.
+
+        Must be called when the catalog was just loaded or saved. Discards
+        any journal kept previously, for this or any other file.
+     */
+    void Start(const wxString& filename);
+
+    /// Stops journaling and deletes the journal, e.g. when changes are discarded.
+    void Discard();
+
+    /**
+        Stops recording changes until the next Start().
+
+        Use when the catalog is changed in ways that the journal can't
+        replay, e.g. when updated from sources. Changes journaled up to this
+        point are kept.
+     */
+    void Suspend();
+
+    /// Is the journal recording changes?
+    bool IsActive() const { return !m_filename.empty() && !m_suspended; }
+
+    /// Records current state of the item
+    void RecordItem(const CatalogItem& item);
+
+    /// Records current state of all items modified since the catalog was saved
+    void RecordChangedItems(const Catalog& catalog);
+
+    /// Records current state of the catalog's header
+    void RecordHeader(Catalog& catalog);
+
+    /// Checks if there are unsaved changes to @a filename left from a previous session.
+    static bool HasUnsavedChanges(const wxString& filename);
+
+    /**
+        Applies unsaved changes left from a previous session to @a catalog,
+        which was just loaded, and continues journaling to it.
+
+        @return Number of recovered items.
+     */
+    int Recover(Catalog& catalog);
+
+private:
+    void Close();
+    void Append(const std::string& record);
+
+    static wxString GetJournalPath(const wxString& filename);
+
+private:
+    wxString m_filename, m_path;
+    wxULongLong m_fileSize;
+    wxDateTime m_fileModTime;
+    wxFile m_file;
+    bool m_suspended = false;
+};
+
+#endif // Poedit_edit_journal_h
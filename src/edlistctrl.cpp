@@ -52,6 +52,7 @@
 #endif
 
 #include <algorithm>
+#include <unordered_set>
 
 
 namespace
@@ -879,6 +880,42 @@ void PoeditListCtrl::RefreshAllItems()
 }
 
 
+void PoeditListCtrl::RefreshCatalogItems(const CatalogItemArray& changed)
+{
+    if (!m_catalog || changed.empty())
+        return;
+
+    if (changed.size() == 1)
+    {
+        RefreshItem(CatalogItemToListItem(changed.front()));
+        return;
+    }
+
+    // map items to rows in a single pass over the catalog, instead of searching
+    // for every item individually:
+    std::unordered_set<const CatalogItem*> lookup;
+    lookup.reserve(changed.size());
+    for (auto& i: changed)
+        lookup.insert(i.get());
+
+    wxDataViewItemArray items;
+    items.reserve(changed.size());
+    auto& all = m_catalog->items();
+    for (size_t i = 0; i < all.size() && items.size() < lookup.size(); i++)
+    {
+        if (lookup.count(all[i].get()))
+        {
+            auto item = CatalogIndexToListItem((int)i);
+            if (item.IsOk())
+                items.push_back(item);
+        }
+    }
+
+    if (!items.empty())
+        m_model->ItemsChanged(items);
+}
+
+
 void PoeditListCtrl::Sort()
 {
     if (!m_catalog)
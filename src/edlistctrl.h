@@ -204,6 +204,9 @@ class PoeditListCtrl : public wxDataViewCtrl
             m_model->ItemChanged(item);
         }
 
+        /// Refresh rows of given catalog items, e.g. after background changes
+        void RefreshCatalogItems(const CatalogItemArray& changed);
+
         int GetCurrentItemListIndex()
         {
             return m_model->GetRow(GetCurrentItem());
@@ -640,6 +640,7 @@ bool FindFrame::DoReplaceInItem(CatalogItemPtr item)
     {
         item->SetTranslations(translations);
         item->SetModified(true);
+        m_owner->JournalItemChange(*item);
         m_owner->MarkAsModified();
         if (item == m_owner->GetCurrentItem())
             m_owner->UpdateToTextCtrl(EditingArea::UndoableEdit);
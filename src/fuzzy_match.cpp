@@ -0,0 +1,284 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2000-2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "fuzzy_match.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// Maximum number of trigram-matched candidates to score for a query, same
+// kind of heuristic as msgmerge's fuzzy index uses to stay fast on large files
+const size_t MAX_SCORED_CANDIDATES = 256;
+
+// Strings shorter than this are compared directly with short queries that
+// don't have trigrams; longer ones can't be similar enough to them anyway
+const size_t SHORT_STRING_LENGTH = 8;
+
+inline uint64_t Trigram(const std::wstring& s, size_t pos)
+{
+    return (uint64_t(uint32_t(s[pos])) << 42) ^ (uint64_t(uint32_t(s[pos + 1])) << 21) ^ uint64_t(uint32_t(s[pos + 2]));
+}
+
+template<typename F>
+inline void ForEachTrigram(const std::wstring& s, F&& f)
+{
+    if (s.length() < 3)
+        return;
+    for (size_t i = 0; i + 2 < s.length(); i++)
+        f(Trigram(s, i));
+}
+
+/**
+    Computes the length of the shortest edit script (insertions and deletions)
+    transforming @a a into @a b, using Myers' O(ND) algorithm.
+
+    Returns -1 if it is longer than @a maxD.
+ */
+int EditDistance(const std::wstring& a, const std::wstring& b, int maxD)
+{
+    const int N = (int)a.length();
+    const int M = (int)b.length();
+
+    if (std::abs(N - M) > maxD)
+        return -1;
+
+    // V[k] is the furthest reaching x on diagonal k (x - y = k), or -1 if the
+    // diagonal wasn't reached yet
+    const int offset = maxD + 1;
+    std::vector<int> V(2 * maxD + 3, -1);
+
+    for (int D = 0; D <= maxD; D++)
+    {
+        for (int k = -D; k <= D; k += 2)
+        {
+            // candidate moves: insertion (down from diagonal k+1) or deletion (right from k-1)
+            const int down = V[offset + k + 1];
+            const int right = V[offset + k - 1];
+            const bool canGoDown = down >= 0 && down - (k + 1) < M;
+            const bool canGoRight = right >= 0 && right < N;
+
+            int x;
+            if (D == 0)
+                x = 0;
+            else if (canGoDown && (!canGoRight || down >= right + 1))
+                x = down;
+            else if (canGoRight)
+                x = right + 1;
+            else
+            {
+                V[offset + k] = -1;
+                continue;
+            }
+
+            int y = x - k;
+            while (x < N && y < M && a[x] == b[y])
+            {
+                x++;
+                y++;
+            }
+            V[offset + k] = x;
+
+            if (x >= N && y >= M)
+                return D;
+        }
+    }
+
+    return -1;
+}
+
+} // anonymous namespace
+
+
+double FuzzyMatcher::SimilarityAbove(const std::wstring& a, const std::wstring& b, double lowerBound)
+{
+    const size_t total = a.length() + b.length();
+    if (total == 0)
+        return 1.0;
+
+    // similarity = (total - D) / total, so it's above lowerBound only if D < (1 - lowerBound) * total
+    const double maxEdits = (1.0 - lowerBound) * total;
+    int maxD = (int)std::ceil(maxEdits) - 1;
+    if (maxD < 0)
+        return 0.0;
+    maxD = std::min(maxD, (int)total);
+
+    const int D = EditDistance(a, b, maxD);
+    if (D < 0)
+        return 0.0;
+
+    const double score = double(total - D) / total;
+    return score > lowerBound ? score : 0.0;
+}
+
+
+double FuzzyMatcher::Similarity(const std::wstring& a, const std::wstring& b, double lowerBound)
+{
+    if (lowerBound <= 0.0)
+        return SimilarityAbove(a, b, -1.0);
+    // "at least lowerBound" is the same as "above a slightly smaller bound":
+    return SimilarityAbove(a, b, std::nextafter(lowerBound, 0.0));
+}
+
+
+void FuzzyMatcher::Add(const wxString& text, size_t id)
+{
+    m_candidates.push_back({text.ToStdWstring(), id});
+}
+
+
+void FuzzyMatcher::Build()
+{
+    m_trigrams.clear();
+    m_shortCandidates.clear();
+
+    std::vector<uint64_t> grams;
+    for (uint32_t i = 0; i < (uint32_t)m_candidates.size(); i++)
+    {
+        auto& text = m_candidates[i].text;
+        if (text.length() < SHORT_STRING_LENGTH)
+            m_shortCandidates.push_back(i);
+        if (text.length() < 3)
+            continue;
+
+        grams.clear();
+        ForEachTrigram(text, [&grams](uint64_t g){ grams.push_back(g); });
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        for (auto g: grams)
+            m_trigrams[g].push_back(i);
+    }
+
+    std::stable_sort(m_shortCandidates.begin(), m_shortCandidates.end(), [this](uint32_t a, uint32_t b)
+    {
+        return m_candidates[a].text.length() < m_candidates[b].text.length();
+    });
+}
+
+
+bool FuzzyMatcher::FindBest(const wxString& query_, const std::function<bool(size_t id)>& accept, Match& result) const
+{
+    if (m_candidates.empty())
+        return false;
+
+    const std::wstring query = query_.ToStdWstring();
+    const double len = (double)query.length();
+
+    // Candidates are scored in order of decreasing promise; ties between
+    // equally similar candidates are resolved in favor of the earlier one.
+    double bestScore = 0.0;
+    uint32_t bestIdx = 0;
+    bool found = false;
+
+    auto consider = [&](uint32_t idx)
+    {
+        auto& c = m_candidates[idx];
+
+        // similarity can't be larger than 2*min(len1,len2)/(len1+len2):
+        const double clen = (double)c.text.length();
+        const double bound = 2 * std::min(len, clen) / (len + clen);
+        if (bound < m_threshold || (found && bound < bestScore))
+            return;
+
+        const double score = SimilarityAbove(query, c.text, std::nextafter(found ? bestScore : m_threshold, 0.0));
+        if (score == 0.0)
+            return;
+        if (!found || score > bestScore || (score == bestScore && idx < bestIdx))
+        {
+            bestScore = score;
+            bestIdx = idx;
+            found = true;
+        }
+    };
+
+    if (query.length() >= 3)
+    {
+        // count shared trigrams for each candidate:
+        std::vector<uint64_t> grams;
+        ForEachTrigram(query, [&grams](uint64_t g){ grams.push_back(g); });
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+
+        std::unordered_map<uint32_t, uint32_t> shared;
+        for (auto g: grams)
+        {
+            auto i = m_trigrams.find(g);
+            if (i == m_trigrams.end())
+                continue;
+            for (auto idx: i->second)
+                shared[idx]++;
+        }
+
+        // filter before limiting the number of candidates, so that acceptable
+        // ones aren't crowded out by those sharing more trigrams:
+        std::vector<std::pair<uint32_t, uint32_t>> ranked;
+        ranked.reserve(shared.size());
+        for (auto& entry: shared)
+        {
+            if (!accept || accept(m_candidates[entry.first].id))
+                ranked.push_back(entry);
+        }
+
+        auto byShared = [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b)
+        {
+            return a.second > b.second || (a.second == b.second && a.first < b.first);
+        };
+        if (ranked.size() > MAX_SCORED_CANDIDATES)
+        {
+            std::partial_sort(ranked.begin(), ranked.begin() + MAX_SCORED_CANDIDATES, ranked.end(), byShared);
+            ranked.resize(MAX_SCORED_CANDIDATES);
+        }
+        else
+        {
+            std::sort(ranked.begin(), ranked.end(), byShared);
+        }
+
+        for (auto& r: ranked)
+            consider(r.first);
+    }
+
+    // Very short strings don't have trigrams, so they must be compared
+    // directly; the list is sorted by length:
+    for (auto idx: m_shortCandidates)
+    {
+        const size_t clen = m_candidates[idx].text.length();
+        if (clen >= 3 && query.length() >= 3)
+            break;  // already indexed by trigrams
+        if (clen > len && 2 * len / (len + clen) < m_threshold)
+            break;
+        if (accept && !accept(m_candidates[idx].id))
+            continue;
+        consider(idx);
+    }
+
+    if (!found)
+        return false;
+
+    result.id = m_candidates[bestIdx].id;
+    result.score = bestScore;
+    return true;
+}
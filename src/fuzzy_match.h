@@ -0,0 +1,117 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2000-2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_fuzzy_match_h
+#define Poedit_fuzzy_match_h
+
+#include <wx/string.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+/**
+    Index for finding the most similar string among a set of candidates.
+
+    This is used for fuzzy matching of messages when merging catalogs, in the
+    same way msgmerge does it: similarity of two strings is computed the same
+    way gettext's fstrcmp() computes it, i.e. as 2*LCS/(len1+len2), derived
+    from the shortest edit script (insertions and deletions only).
+
+    To avoid comparing every query with every candidate, the candidates are
+    indexed by character trigrams and only those sharing some trigrams with
+    the query are scored (best candidates first), with the edit distance
+    computation cut off as soon as it can't beat the best match so far.
+    Very short strings, which have no trigrams, are compared with all
+    candidates of suitable length.
+
+    Searching is thread-safe once the index is built.
+ */
+class FuzzyMatcher
+{
+public:
+    /// Minimum similarity msgmerge requires for fuzzy matches
+    static constexpr double DEFAULT_THRESHOLD = 0.6;
+
+    explicit FuzzyMatcher(double threshold = DEFAULT_THRESHOLD) : m_threshold(threshold) {}
+
+    /// Adds a candidate string, identified by @a id.
+    void Add(const wxString& text, size_t id);
+
+    /// Must be called after adding all candidates and before searching.
+    void Build();
+
+    /// Returns true if there are no candidates.
+    bool IsEmpty() const { return m_candidates.empty(); }
+
+    struct Match
+    {
+        size_t id;
+        double score;
+    };
+
+    /**
+        Finds the candidate most similar to @a query.
+
+        @param query   String to search for.
+        @param accept  Optional filter; candidates for which it returns false
+                       are ignored.
+        @param result  Receives the best match, if any was found; if there
+                       are several equally good candidates, the first
+                       added one is returned.
+
+        @return true if a match with similarity above the threshold was found.
+     */
+    bool FindBest(const wxString& query, const std::function<bool(size_t id)>& accept, Match& result) const;
+
+    /**
+        Computes similarity of two strings, in range 0 (completely different)
+        to 1 (identical). Returns 0 if the similarity is lower than
+        @a lowerBound, which makes the computation a lot faster.
+     */
+    static double Similarity(const std::wstring& a, const std::wstring& b, double lowerBound = 0.0);
+
+private:
+    struct Candidate
+    {
+        std::wstring text;
+        size_t id;
+    };
+
+    // Computes similarity if it's strictly greater than lowerBound, returns 0 otherwise
+    static double SimilarityAbove(const std::wstring& a, const std::wstring& b, double lowerBound);
+
+    double m_threshold;
+    std::vector<Candidate> m_candidates;
+    // trigram -> indexes of candidates containing it
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_trigrams;
+    // short candidates, sorted by length, for matching short queries
+    std::vector<uint32_t> m_shortCandidates;
+};
+
+#endif // Poedit_fuzzy_match_h
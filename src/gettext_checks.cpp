@@ -0,0 +1,682 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2000-2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "gettext_checks.h"
+
+#include "concurrency.h"
+
+#include <wx/intl.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+
+namespace
+{
+
+/**
+    Arguments used by a format string.
+
+    Types are represented by normalized conversion specifiers (e.g. "ld"
+    for both %ld and %li), so that compatible arguments compare equal.
+ */
+struct FormatSpec
+{
+    bool valid = true;
+    wxString error;
+
+    std::vector<std::wstring> unnamed;
+    std::map<std::wstring, std::wstring> named;
+
+    bool Fail(const wxString& reason)
+    {
+        valid = false;
+        error = reason;
+        return false;
+    }
+};
+
+
+inline bool IsDigit(wchar_t c) { return c >= '0' && c <= '9'; }
+
+
+class CFormatParser
+{
+public:
+    /// @a objc enables Objective-C's %@ (object argument) directive
+    explicit CFormatParser(const std::wstring& s, bool objc = false) : m_s(s), m_objc(objc) {}
+
+    FormatSpec Parse()
+    {
+        FormatSpec spec;
+        if (DoParse(spec))
+            BuildArgsTable(spec);
+        return spec;
+    }
+
+private:
+    bool DoParse(FormatSpec& spec)
+    {
+        for (m_pos = 0; m_pos < m_s.size(); m_pos++)
+        {
+            if (m_s[m_pos] != '%')
+                continue;
+            if (++m_pos == m_s.size())
+                return spec.Fail(_("The string ends in the middle of a directive."));
+            if (m_s[m_pos] == '%')
+                continue;
+
+            unsigned number = 0;
+            if (!ReadArgNumber(spec, number))
+                return false;
+
+            while (m_pos < m_s.size() && wcschr(L"-+ #0'I", m_s[m_pos]))
+                m_pos++;
+
+            // width:
+            if (m_pos < m_s.size() && m_s[m_pos] == '*')
+            {
+                m_pos++;
+                unsigned widthNumber = 0;
+                if (!ReadArgNumber(spec, widthNumber) || !UseArg(spec, widthNumber, L"d"))
+                    return false;
+            }
+            while (m_pos < m_s.size() && IsDigit(m_s[m_pos]))
+                m_pos++;
+
+            // precision:
+            if (m_pos < m_s.size() && m_s[m_pos] == '.')
+            {
+                m_pos++;
+                if (m_pos < m_s.size() && m_s[m_pos] == '*')
+                {
+                    m_pos++;
+                    unsigned precisionNumber = 0;
+                    if (!ReadArgNumber(spec, precisionNumber) || !UseArg(spec, precisionNumber, L"d"))
+                        return false;
+                }
+                while (m_pos < m_s.size() && IsDigit(m_s[m_pos]))
+                    m_pos++;
+            }
+
+            std::wstring size = ReadSize();
+            if (m_pos == m_s.size())
+                return spec.Fail(_("The string ends in the middle of a directive."));
+
+            std::wstring type;
+            const wchar_t conv = m_s[m_pos];
+            switch (conv)
+            {
+                case 'd': case 'i':
+                    type = size + L"d";
+                    break;
+                case 'o': case 'u': case 'x': case 'X':
+                    type = size + L"u";
+                    break;
+                case 'c':
+                    type = (size == L"l") ? L"lc" : L"c";
+                    break;
+                case 'C':
+                    type = L"lc";
+                    break;
+                case 's':
+                    type = (size == L"l") ? L"ls" : L"s";
+                    break;
+                case 'S':
+                    type = L"ls";
+                    break;
+                case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                    type = (size == L"ll") ? L"Lf" : L"f";
+                    break;
+                case 'p':
+                    type = L"p";
+                    break;
+                case '@':
+                    if (!m_objc)
+                        return spec.Fail(wxString::Format(_(L"“%s” is not a valid conversion specifier."), wxString(1, conv)));
+                    type = L"@";
+                    break;
+                case 'n':
+                    type = size + L"n";
+                    break;
+                case '<':
+                {
+                    // system-dependent <inttypes.h> macro, e.g. %<PRId64>
+                    auto end = m_s.find('>', m_pos);
+                    if (end == std::wstring::npos)
+                        return spec.Fail(_("The string ends in the middle of a directive."));
+                    auto macro = m_s.substr(m_pos + 1, end - m_pos - 1);
+                    if (macro.length() < 5 || macro.compare(0, 3, L"PRI") != 0 || !wcschr(L"diouxX", macro[3]))
+                        return spec.Fail(wxString::Format(_(L"“%s” is not a valid format macro."), macro));
+                    type = L"<" + macro.substr(4) + (wcschr(L"di", macro[3]) ? L"d>" : L"u>");
+                    m_pos = end;
+                    break;
+                }
+                default:
+                    return spec.Fail(wxString::Format(_(L"“%s” is not a valid conversion specifier."), wxString(1, conv)));
+            }
+
+            if (!UseArg(spec, number, type))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Reads optional "N$" argument number
+    bool ReadArgNumber(FormatSpec& spec, unsigned& number)
+    {
+        size_t p = m_pos;
+        unsigned n = 0;
+        while (p < m_s.size() && IsDigit(m_s[p]))
+            n = n * 10 + (m_s[p++] - '0');
+        if (p == m_pos || p == m_s.size() || m_s[p] != '$')
+            return true;
+        if (n == 0)
+            return spec.Fail(_("Argument number 0 is not a positive integer."));
+        number = n;
+        m_pos = p + 1;
+        return true;
+    }
+
+    std::wstring ReadSize()
+    {
+        std::wstring size;
+        while (m_pos < m_s.size())
+        {
+            switch (m_s[m_pos])
+            {
+                case 'h':
+                    size = (size == L"h") ? L"hh" : L"h";
+                    break;
+                case 'l':
+                    size = (size == L"l") ? L"ll" : L"l";
+                    break;
+                case 'L': case 'q':
+                    size = L"ll";
+                    break;
+                case 'j':
+                    size = L"j";
+                    break;
+                case 'z': case 'Z':
+                    size = L"z";
+                    break;
+                case 't':
+                    size = L"t";
+                    break;
+                default:
+                    return size;
+            }
+            m_pos++;
+        }
+        return size;
+    }
+
+    bool UseArg(FormatSpec& spec, unsigned number, const std::wstring& type)
+    {
+        if (number)
+        {
+            if (m_sequential)
+                return spec.Fail(_("The string mixes numbered and unnumbered arguments."));
+            m_numbered = true;
+        }
+        else
+        {
+            if (m_numbered)
+                return spec.Fail(_("The string mixes numbered and unnumbered arguments."));
+            m_sequential = true;
+            number = m_nextArg++;
+        }
+        m_args.emplace_back(number, type);
+        return true;
+    }
+
+    void BuildArgsTable(FormatSpec& spec)
+    {
+        for (auto& a: m_args)
+        {
+            if (spec.unnamed.size() < a.first)
+                spec.unnamed.resize(a.first);
+            auto& t = spec.unnamed[a.first - 1];
+            if (t.empty())
+                t = a.second;
+            else if (t != a.second)
+            {
+                spec.Fail(wxString::Format(_("Argument %u is used with different types."), a.first));
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < spec.unnamed.size(); i++)
+        {
+            if (spec.unnamed[i].empty())
+            {
+                spec.Fail(wxString::Format(_("The string doesn't use argument %u."), unsigned(i + 1)));
+                return;
+            }
+        }
+    }
+
+private:
+    const std::wstring& m_s;
+    const bool m_objc;
+    size_t m_pos = 0;
+    unsigned m_nextArg = 1;
+    bool m_numbered = false, m_sequential = false;
+    std::vector<std::pair<unsigned, std::wstring>> m_args;
+};
+
+
+FormatSpec ParsePythonFormat(const std::wstring& s)
+{
+    FormatSpec spec;
+
+    for (size_t pos = 0; pos < s.size(); pos++)
+    {
+        if (s[pos] != '%')
+            continue;
+        if (++pos == s.size())
+        {
+            spec.Fail(_("The string ends in the middle of a directive."));
+            return spec;
+        }
+
+        std::wstring name;
+        bool hasName = false;
+        if (s[pos] == '(')
+        {
+            // names may contain balanced parentheses
+            int depth = 1;
+            size_t start = ++pos;
+            for (; pos < s.size() && depth > 0; pos++)
+            {
+                if (s[pos] == '(')
+                    depth++;
+                else if (s[pos] == ')')
+                    depth--;
+            }
+            if (depth > 0)
+            {
+                spec.Fail(_("The string ends in the middle of a directive."));
+                return spec;
+            }
+            name = s.substr(start, pos - 1 - start);
+            hasName = true;
+        }
+
+        while (pos < s.size() && wcschr(L"-+ #0", s[pos]))
+            pos++;
+
+        auto readStarOrDigits = [&]() -> bool
+        {
+            if (pos < s.size() && s[pos] == '*')
+            {
+                if (hasName)
+                    return spec.Fail(_("Named arguments can't use * for width or precision."));
+                spec.unnamed.push_back(L"i");
+                pos++;
+            }
+            else
+            {
+                while (pos < s.size() && IsDigit(s[pos]))
+                    pos++;
+            }
+            return true;
+        };
+
+        if (!readStarOrDigits())
+            return spec;
+        if (pos < s.size() && s[pos] == '.')
+        {
+            pos++;
+            if (!readStarOrDigits())
+                return spec;
+        }
+
+        while (pos < s.size() && wcschr(L"hlL", s[pos]))
+            pos++;
+
+        if (pos == s.size())
+        {
+            spec.Fail(_("The string ends in the middle of a directive."));
+            return spec;
+        }
+
+        std::wstring type;
+        switch (s[pos])
+        {
+            case '%':
+                if (!hasName)
+                    continue;
+                type = L"%";
+                break;
+            case 'c':
+                type = L"c";
+                break;
+            case 's': case 'r': case 'a':
+                type = L"s";
+                break;
+            case 'i': case 'd': case 'u': case 'o': case 'x': case 'X':
+                type = L"i";
+                break;
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G':
+                type = L"f";
+                break;
+            default:
+                spec.Fail(wxString::Format(_(L"“%s” is not a valid conversion specifier."), wxString(1, s[pos])));
+                return spec;
+        }
+
+        if (hasName)
+        {
+            auto existing = spec.named.find(name);
+            if (existing != spec.named.end() && existing->second != type)
+            {
+                spec.Fail(wxString::Format(_(L"Argument “%s” is used with different types."), name));
+                return spec;
+            }
+            spec.named[name] = type;
+        }
+        else
+        {
+            spec.unnamed.push_back(type);
+        }
+    }
+
+    if (!spec.named.empty() && !spec.unnamed.empty())
+        spec.Fail(_("The string mixes named and unnamed arguments."));
+
+    return spec;
+}
+
+
+FormatSpec ParseFormat(const std::string& format, const wxString& str)
+{
+    const std::wstring s = str.ToStdWstring();
+    if (format == "c" || format == "objc")
+        return CFormatParser(s, /*objc=*/format == "objc").Parse();
+    else
+        return ParsePythonFormat(s);
+}
+
+
+// Are argument types compatible? In non-strict mode, Python's %s accepts anything.
+inline bool SameType(const std::string& format, const std::wstring& a, const std::wstring& b, bool strict)
+{
+    if (a == b)
+        return true;
+    return format == "python" && !strict && (a == L"s" || b == L"s");
+}
+
+
+/**
+    Checks format string in translation against the source one.
+
+    In strict mode, the translation must use all arguments; otherwise it may
+    omit some (e.g. the number in plural forms used only for n=1).
+
+    Returns error description or empty string.
+ */
+wxString CheckFormatCompatibility(const std::string& format, const FormatSpec& source, const FormatSpec& trans, bool strict)
+{
+    if (!trans.valid)
+        return wxString::Format(_(L"Translation isn’t a valid format string: %s"), trans.error);
+
+    if (!source.named.empty() && !trans.unnamed.empty())
+        return _("Source text uses named format arguments, but translation uses unnamed ones.");
+    if (!source.unnamed.empty() && !trans.named.empty())
+        return _("Source text uses unnamed format arguments, but translation uses named ones.");
+
+    for (auto& t: trans.named)
+    {
+        auto s = source.named.find(t.first);
+        if (s == source.named.end())
+            return wxString::Format(_(L"Format argument “%s” from translation doesn’t exist in source text."), t.first);
+        if (!SameType(format, s->second, t.second, strict))
+            return wxString::Format(_(L"Format specifications for argument “%s” in source text and translation are not the same."), t.first);
+    }
+    if (strict)
+    {
+        for (auto& s: source.named)
+        {
+            if (trans.named.find(s.first) == trans.named.end())
+                return wxString::Format(_(L"Format argument “%s” is missing from translation."), s.first);
+        }
+    }
+
+    const size_t n1 = source.unnamed.size();
+    const size_t n2 = trans.unnamed.size();
+    // Python arguments tuple must always match exactly
+    const bool exactCount = strict || format == "python";
+    if (exactCount ? n1 != n2 : n2 > n1)
+        return _("The number of format specifications in source text and translation doesn’t match.");
+
+    for (size_t i = 0; i < std::min(n1, n2); i++)
+    {
+        if (!SameType(format, source.unnamed[i], trans.unnamed[i], strict))
+            return wxString::Format(_("Format specifications in source text and translation for argument %u are not the same."), unsigned(i + 1));
+    }
+
+    return wxString();
+}
+
+
+inline bool BeginsWithNewline(const wxString& s) { return !s.empty() && s[0] == '\n'; }
+inline bool EndsWithNewline(const wxString& s) { return !s.empty() && s.Last() == '\n'; }
+
+} // anonymous namespace
+
+
+GettextChecker::GettextChecker(Catalog& catalog)
+    : m_catalog(catalog), m_nplurals(0)
+{
+    auto& hdr = m_catalog.Header();
+
+    // Evaluate plural forms upfront, items are then checked in parallel
+    if (hdr.HasHeader("Plural-Forms"))
+    {
+        auto plurals = m_catalog.GetPluralForms();
+        if (!plurals)
+        {
+            m_pluralFormsError = _("The Plural-Forms header contains an invalid expression.");
+        }
+        else
+        {
+            m_nplurals = plurals.nplurals();
+            std::vector<int> counts(m_nplurals, 0);
+            unsigned maxValue = 0;
+            for (int n = 0; n < PluralFormsExpr::MAX_EXAMPLES_COUNT; n++)
+            {
+                auto form = plurals.evaluate_for_n(n);
+                maxValue = std::max(maxValue, form);
+                if (form < m_nplurals)
+                    counts[form]++;
+            }
+
+            if (maxValue >= m_nplurals)
+            {
+                m_pluralFormsError = wxString::Format(_("The plural expression can produce values as large as %u, but nplurals is %u."),
+                                                      maxValue, m_nplurals);
+            }
+
+            for (auto c: counts)
+                m_pluralFormUsedOften.push_back(c > 1);
+        }
+    }
+}
+
+
+bool GettextChecker::IsSupportedFormat(const std::string& format)
+{
+    return format == "c" || format == "objc" || format == "python";
+}
+
+
+bool GettextChecker::SupportsAllFormats() const
+{
+    for (auto& item: m_catalog.items())
+    {
+        if (item->IsFuzzy() || item->GetTranslation().empty())
+            continue;  // not checked
+        auto format = item->GetFormatFlag();
+        if (!format.empty() && !IsSupportedFormat(format))
+            return false;
+    }
+    return true;
+}
+
+
+bool GettextChecker::CheckItem(CatalogItem& item) const
+{
+    if (item.IsFuzzy() || item.GetTranslation().empty())
+        return false;
+
+    auto error = [&item](const wxString& msg)
+    {
+        item.SetIssue(CatalogItem::Issue::Error, msg);
+        return true;
+    };
+
+    const wxString& source = item.HasPlural() ? item.GetRawPluralString() : item.GetRawString();
+
+    if (item.HasPlural())
+    {
+        if (!m_pluralFormsError.empty())
+            return error(m_pluralFormsError);
+        if (m_nplurals && item.GetNumberOfTranslations() != m_nplurals)
+        {
+            return error(wxString::Format(_("Translation has %u plural forms, but the Plural-Forms header expects %u."),
+                                          item.GetNumberOfTranslations(), m_nplurals));
+        }
+    }
+
+    // Leading and trailing newlines must be consistent:
+    if (item.HasPlural() && BeginsWithNewline(item.GetRawString()) != BeginsWithNewline(source))
+        return error(_("Singular and plural source texts don’t both begin with a newline."));
+    if (item.HasPlural() && EndsWithNewline(item.GetRawString()) != EndsWithNewline(source))
+        return error(_("Singular and plural source texts don’t both end with a newline."));
+
+    for (auto& t: item.GetTranslations())
+    {
+        if (t.empty())
+            continue;
+        if (BeginsWithNewline(t) != BeginsWithNewline(source))
+            return error(_("Source text and translation don’t both begin with a newline."));
+        if (EndsWithNewline(t) != EndsWithNewline(source))
+            return error(_("Source text and translation don’t both end with a newline."));
+    }
+
+    // Format strings:
+    const auto format = item.GetFormatFlag();
+    if (!IsSupportedFormat(format))
+        return false;
+
+    const auto sourceSpec = ParseFormat(format, source);
+    if (!sourceSpec.valid)
+        return false;  // msgfmt only checks translations of valid format strings
+
+    unsigned index = 0;
+    for (auto& t: item.GetTranslations())
+    {
+        const unsigned form = index++;
+        if (t.empty())
+            continue;
+
+        bool strict = true;
+        if (item.HasPlural() && form < m_pluralFormUsedOften.size())
+            strict = m_pluralFormUsedOften[form];
+
+        auto problem = CheckFormatCompatibility(format, sourceSpec, ParseFormat(format, t), strict);
+        if (!problem.empty())
+            return error(problem);
+    }
+
+    return false;
+}
+
+
+int GettextChecker::CheckItems()
+{
+    auto& items = m_catalog.items();
+
+    std::atomic<int> errors(0);
+    dispatch::parallel_for(items.size(), [&](size_t i)
+    {
+        if (CheckItem(*items[i]))
+            errors++;
+    });
+
+    return errors;
+}
+
+
+std::vector<wxString> GettextChecker::CheckHeader() const
+{
+    std::vector<wxString> problems;
+
+    auto& hdr = m_catalog.Header();
+
+    static const struct
+    {
+        const char *key;
+        const char *defaultValue;
+    } requiredFields[] =
+    {
+        { "Project-Id-Version",        "PACKAGE VERSION" },
+        { "PO-Revision-Date",          "YEAR-MO-DA HO:MI+ZONE" },
+        { "Last-Translator",           "FULL NAME <EMAIL@ADDRESS>" },
+        { "Language-Team",             "LANGUAGE <LL@li.org>" },
+        { "MIME-Version",              nullptr },
+        { "Content-Type",              "text/plain; charset=CHARSET" },
+        { "Content-Transfer-Encoding", "ENCODING" },
+        { "Language",                  nullptr }
+    };
+
+    for (auto& f: requiredFields)
+    {
+        if (!hdr.HasHeader(f.key))
+            problems.push_back(wxString::Format(_(L"Header field “%s” is missing."), f.key));
+        else if (f.defaultValue && hdr.GetHeader(f.key) == f.defaultValue)
+            problems.push_back(wxString::Format(_(L"Header field “%s” still has the initial default value."), f.key));
+    }
+
+    if (!m_pluralFormsError.empty())
+    {
+        problems.push_back(m_pluralFormsError);
+    }
+    else if (!hdr.HasHeader("Plural-Forms"))
+    {
+        for (auto& item: m_catalog.items())
+        {
+            if (item->HasPlural() && !item->IsFuzzy() && !item->GetTranslation().empty())
+            {
+                problems.push_back(_("Catalog has plural form translations, but lacks the Plural-Forms header."));
+                break;
+            }
+        }
+    }
+
+    return problems;
+}
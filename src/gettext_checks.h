@@ -0,0 +1,80 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2000-2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_gettext_checks_h
+#define Poedit_gettext_checks_h
+
+#include "catalog.h"
+
+#include <string>
+#include <vector>
+
+
+/**
+    Checks translations for errors, in the same way `msgfmt --check` does.
+
+    This covers compatibility of format strings (c-format and python-format),
+    consistency of plural translations with the Plural-Forms header, leading
+    and trailing newlines, and sanity of the header. Like msgfmt, only
+    translated and non-fuzzy items are checked.
+
+    Problematic items get an error issue set directly; problems with the
+    header are returned separately, because they don't belong to any item.
+ */
+class GettextChecker
+{
+public:
+    explicit GettextChecker(Catalog& catalog);
+
+    /// Checks all items, in parallel. Returns the number of errors found.
+    int CheckItems();
+
+    /// Checks a single item. Returns true if an error was found.
+    bool CheckItem(CatalogItem& item) const;
+
+    /// Checks the header and returns descriptions of found problems.
+    std::vector<wxString> CheckHeader() const;
+
+    /**
+        Returns true if all checked items use format strings this class
+        can verify (or none at all). If not, msgfmt must be used instead
+        to perform the full set of checks.
+     */
+    bool SupportsAllFormats() const;
+
+    /// Returns true if format strings of given kind (e.g. "c") are checked.
+    static bool IsSupportedFormat(const std::string& format);
+
+private:
+    Catalog& m_catalog;
+
+    unsigned m_nplurals;
+    wxString m_pluralFormsError;
+    // true for plural forms used for more than one value of n; the number
+    // argument may be omitted from translations of the others
+    std::vector<bool> m_pluralFormUsedOften;
+};
+
+#endif // Poedit_gettext_checks_h
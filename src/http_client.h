@@ -87,21 +87,34 @@ public:
 
     /// Returns generated body of the request.
     virtual std::string body() const = 0;
+
+    /**
+        Returns the body in a buffer that can be sent from directly, in
+        chunks, without copying it into the request. The buffer is kept
+        alive until the request finishes.
+     */
+    virtual std::shared_ptr<const std::string> shared_body() const
+        { return std::make_shared<const std::string>(body()); }
 };
 
 /// Stores unspecified binary data
 class octet_stream_data : public http_body_data
 {
 public:
-    octet_stream_data(const std::string& body) : m_body(body) {};
+    octet_stream_data(const std::string& body) : m_body(std::make_shared<const std::string>(body)) {};
+    /// Takes ownership of @a body without copying it, use for large data.
+    octet_stream_data(std::string&& body) : m_body(std::make_shared<const std::string>(std::move(body))) {};
 
     /// Content-Type header to use with the data.
     std::string content_type() const override { return "application/octet-stream"; };
 
     /// Returns generated body of the request.
-    std::string body() const override { return m_body; };
+    std::string body() const override { return *m_body; };
+
+    std::shared_ptr<const std::string> shared_body() const override { return m_body; }
+
 private:
-    std::string m_body;
+    std::shared_ptr<const std::string> m_body;
 };
 
 /// Stores POSTed data (RFC 1867)
@@ -44,6 +44,7 @@
 #include <cpprest/http_client.h>
 #include <cpprest/http_msg.h>
 #include <cpprest/filestream.h>
+#include <cpprest/rawptrstream.h>
 
 #include <regex>
 
@@ -208,20 +209,22 @@ public:
     {
         auto req = build_request(http::methods::POST, url, hdrs);
 
-        auto body = data.body();
-        if ((m_flags & http_client::use_gzip_request_body) && body.size() > 256)
+        auto body = data.shared_body();
+        if ((m_flags & http_client::use_gzip_request_body) && body->size() > 256)
         {
-            body = http_client::gzip_compress_body(body);
+            body = std::make_shared<const std::string>(http_client::gzip_compress_body(*body));
             req.headers().add(http::header_names::content_encoding, _XPLATSTR("gzip"));
         }
 
-        req.set_body(body, data.content_type());
-        req.headers().set_content_length(body.size());
+        // send the body from the buffer, in chunks, instead of copying it into the request:
+        auto stream = concurrency::streams::rawptr_stream<uint8_t>::open_istream(reinterpret_cast<const uint8_t*>(body->data()), body->size());
+        req.set_body(stream, body->size(), to_string_t(data.content_type()));
 
         return
         m_native.request(req)
         .then([=](http::http_response response)
         {
+            (void)body; // keep the buffer alive until the request finishes
             handle_error(response);
             return ::json::parse(response.extract_utf8string().get());
         });
@@ -132,15 +132,19 @@ public:
         auto request = build_request(@"POST", url, hdrs);
         [request setValue:str::to_NS(body_data.content_type()) forHTTPHeaderField:@"Content-Type"];
         
-        auto body = body_data.body();
-        if ((m_flags & http_client::use_gzip_request_body) && body.size() > 256)
+        auto body = body_data.shared_body();
+        if ((m_flags & http_client::use_gzip_request_body) && body->size() > 256)
         {
-            body = http_client::gzip_compress_body(body);
+            body = std::make_shared<const std::string>(http_client::gzip_compress_body(*body));
             [request setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
         }
 
-        [request setValue:[NSString stringWithFormat:@"%lu", body.size()] forHTTPHeaderField:@"Content-Length"];
-        [request setHTTPBody:[NSData dataWithBytes:body.data() length:body.size()]];
+        [request setValue:[NSString stringWithFormat:@"%lu", body->size()] forHTTPHeaderField:@"Content-Length"];
+        // use the buffer directly instead of copying it, keeping it alive for as long as NSData needs it:
+        auto bodyData = [[NSData alloc] initWithBytesNoCopy:(void*)body->data()
+                                                     length:body->size()
+                                                deallocator:^(void*, NSUInteger){ (void)body; }];
+        [request setHTTPBody:bodyData];
 
         auto task = [m_session dataTaskWithRequest:request completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
             try
@@ -447,7 +447,7 @@ dispatch::future<void> LocalazyClient::DownloadFile(const std::wstring& output_f
 }
 
 
-dispatch::future<void> LocalazyClient::UploadFile(const std::string& file_buffer, std::shared_ptr<FileSyncMetadata> meta_)
+dispatch::future<void> LocalazyClient::UploadFile(std::string file_buffer, std::shared_ptr<FileSyncMetadata> meta_)
 {
     class upload_json_data : public octet_stream_data
     {
@@ -461,7 +461,7 @@ dispatch::future<void> LocalazyClient::UploadFile(const std::string& file_buffer
     std::string prefix("/projects/" + meta->projectId + "/exchange");
     http_client::headers headers {{"Authorization", GetAuthorization(meta->projectId)}};
 
-    return m_api->post(prefix + "/import", upload_json_data(file_buffer), headers)
+    return m_api->post(prefix + "/import", upload_json_data(std::move(file_buffer)), headers)
         .then([this,prefix,headers] (json r) {
             auto ok = r.at("result").get<bool>();
             if (!ok)
@@ -0,0 +1,225 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2000-2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "mo_compiler.h"
+
+#include <wx/file.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+const uint32_t MO_MAGIC = 0x950412de;
+
+// MO header (revision 0) has 7 32-bit fields
+const uint32_t HEADER_SIZE = 7 * sizeof(uint32_t);
+
+bool IsPrime(uint32_t candidate)
+{
+    // no even numbers and none less than 10 will be passed here
+    uint32_t divn = 3;
+    uint32_t sq = divn * divn;
+
+    while (sq < candidate && candidate % divn != 0)
+    {
+        ++divn;
+        sq += 4 * divn;
+        ++divn;
+    }
+
+    return candidate % divn != 0;
+}
+
+// Same as gettext's next_prime(): smallest odd prime >= seed
+uint32_t NextPrime(uint32_t seed)
+{
+    // make it definitely odd
+    seed |= 1;
+
+    while (!IsPrime(seed))
+        seed += 2;
+
+    return seed;
+}
+
+inline void AppendUInt32(std::string& out, uint32_t value)
+{
+    // MO files are written in native byte order, as msgfmt does by default
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+} // anonymous namespace
+
+
+uint32_t MOCompiler::HashString(const char *str)
+{
+    // This is the hash_string() function from gettext's hash-string.c,
+    // which is what the runtime uses to look strings up:
+    const int HASHWORDBITS = 32;
+
+    uint32_t hval = 0;
+    while (*str != '\0')
+    {
+        hval <<= 4;
+        hval += (unsigned char) *str++;
+        uint32_t g = hval & ((uint32_t) ~0 << (HASHWORDBITS - 4));
+        if (g != 0)
+        {
+            hval ^= g >> (HASHWORDBITS - 8);
+            hval ^= g;
+        }
+    }
+    return hval;
+}
+
+
+bool MOCompiler::NeedsSystemDependentStrings(const wxString& format)
+{
+    // Look for directives like %<PRId64> or %Id, which msgfmt stores in
+    // a special section of the file, in revision 1 format:
+    for (auto i = format.begin(); i != format.end(); ++i)
+    {
+        if (*i != '%')
+            continue;
+        if (++i == format.end())
+            break;
+        if (*i == '%')
+            continue;
+        while (i != format.end() && wxStrchr(L"0123456789$-+ #'.*", (wchar_t)*i))
+            ++i;
+        if (i == format.end())
+            break;
+        if (*i == '<' || *i == 'I')
+            return true;
+    }
+    return false;
+}
+
+
+std::string MOCompiler::Compile()
+{
+    // Entries must be sorted by the original string for the runtime's
+    // binary search fallback. Like msgfmt, compare only up to the first NUL,
+    // i.e. ignore msgid_plural:
+    std::stable_sort(m_messages.begin(), m_messages.end(), [](const Message& a, const Message& b)
+    {
+        return strcmp(a.key.c_str(), b.key.c_str()) < 0;
+    });
+    m_messages.erase(std::unique(m_messages.begin(), m_messages.end(), [](const Message& a, const Message& b)
+                     {
+                         return strcmp(a.key.c_str(), b.key.c_str()) == 0;
+                     }),
+                     m_messages.end());
+
+    const uint32_t count = (uint32_t)m_messages.size();
+
+    // Calculate hash table size: use the next prime number after 4/3 * count,
+    // but ensure M > 2:
+    uint32_t hashSize = NextPrime((count * 4) / 3);
+    if (hashSize <= 2)
+        hashSize = 3;
+
+    std::vector<uint32_t> hashTable(hashSize, 0);
+    for (uint32_t j = 0; j < count; j++)
+    {
+        const uint32_t hashVal = HashString(m_messages[j].key.c_str());
+        uint32_t idx = hashVal % hashSize;
+
+        if (hashTable[idx] != 0)
+        {
+            // We need the second hashing function:
+            const uint32_t incr = 1 + (hashVal % (hashSize - 2));
+            do
+            {
+                if (idx >= hashSize - incr)
+                    idx -= hashSize - incr;
+                else
+                    idx += incr;
+            }
+            while (hashTable[idx] != 0);
+        }
+
+        hashTable[idx] = j + 1;
+    }
+
+    const uint32_t origTabOffset = HEADER_SIZE;
+    const uint32_t transTabOffset = origTabOffset + count * 2 * sizeof(uint32_t);
+    const uint32_t hashTabOffset = transTabOffset + count * 2 * sizeof(uint32_t);
+    const uint32_t stringsOffset = hashTabOffset + hashSize * sizeof(uint32_t);
+
+    size_t stringsSize = 0;
+    for (auto& m: m_messages)
+        stringsSize += m.key.size() + 1 + m.translation.size() + 1;
+
+    std::string out;
+    out.reserve(stringsOffset + stringsSize);
+
+    AppendUInt32(out, MO_MAGIC);
+    AppendUInt32(out, 0); // revision
+    AppendUInt32(out, count);
+    AppendUInt32(out, origTabOffset);
+    AppendUInt32(out, transTabOffset);
+    AppendUInt32(out, hashSize);
+    AppendUInt32(out, hashTabOffset);
+
+    // Strings are stored after the hash table, all originals first, each
+    // NUL-terminated (but the terminator is not included in the length):
+    uint32_t offset = stringsOffset;
+    for (auto& m: m_messages)
+    {
+        AppendUInt32(out, (uint32_t)m.key.size());
+        AppendUInt32(out, offset);
+        offset += (uint32_t)m.key.size() + 1;
+    }
+    for (auto& m: m_messages)
+    {
+        AppendUInt32(out, (uint32_t)m.translation.size());
+        AppendUInt32(out, offset);
+        offset += (uint32_t)m.translation.size() + 1;
+    }
+
+    for (auto h: hashTable)
+        AppendUInt32(out, h);
+
+    for (auto& m: m_messages)
+        out.append(m.key.c_str(), m.key.size() + 1);
+    for (auto& m: m_messages)
+        out.append(m.translation.c_str(), m.translation.size() + 1);
+
+    return out;
+}
+
+
+bool MOCompiler::WriteFile(const wxString& filename)
+{
+    const std::string data = Compile();
+
+    wxFile f;
+    if (!f.Create(filename, /*overwrite=*/true))
+        return false;
+    return f.Write(data.data(), data.size()) == data.size() && f.Close();
+}
@@ -0,0 +1,95 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2000-2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_mo_compiler_h
+#define Poedit_mo_compiler_h
+
+#include <wx/string.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+    Writer of gettext MO files.
+
+    Builds the binary catalog, including the hash table, directly from
+    messages' data. The output uses the same format as GNU msgfmt's (native
+    endianness, no alignment) and is loadable by libintl, but isn't
+    necessarily byte-for-byte identical to it: the hash table is sized the
+    way older msgfmt versions did. Unlike msgfmt, it doesn't need to run
+    external process or to have the data in a PO file first.
+
+    System-dependent strings (c-format directives using <inttypes.h> macros)
+    are not supported; use NeedsSystemDependentStrings() to check for them.
+ */
+class MOCompiler
+{
+public:
+    MOCompiler() {}
+
+    /**
+        Adds a message to the catalog.
+
+        All strings must be encoded in the catalog's charset already.
+
+        @param key          Message's original: msgid, prefixed with the
+                            context and '\x04' if the message has one, and
+                            followed by '\0' and msgid_plural for plural
+                            messages.
+        @param translation  Translation, with plural forms separated by '\0'.
+     */
+    void AddMessage(std::string&& key, std::string&& translation)
+    {
+        m_messages.push_back({std::move(key), std::move(translation)});
+    }
+
+    /// Returns number of messages added so far
+    size_t GetCount() const { return m_messages.size(); }
+
+    /// Returns the compiled MO data.
+    std::string Compile();
+
+    /// Compiles the data and writes it into @a filename.
+    bool WriteFile(const wxString& filename);
+
+    /// Checks if c-format string uses directives that need system-dependent strings support.
+    static bool NeedsSystemDependentStrings(const wxString& format);
+
+    /// Hash function used by gettext for MO files' hash tables.
+    static uint32_t HashString(const char *str);
+
+private:
+    struct Message
+    {
+        std::string key;
+        std::string translation;
+    };
+
+    std::vector<Message> m_messages;
+};
+
+#endif // Poedit_mo_compiler_h
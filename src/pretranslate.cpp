@@ -27,6 +27,7 @@
 
 #include "configuration.h"
 #include "errors.h"
+#include "json.h"
 #include "progress.h"
 #include "str_helpers.h"
 #include "tm/transmem.h"
@@ -34,12 +35,11 @@
 
 #include <wx/stopwatch.h>
 
-#include <boost/thread/thread.hpp>
-
 #include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <thread>
 
@@ -53,6 +53,9 @@ namespace
 {
 
 
+typedef std::chrono::steady_clock Clock;
+
+
 struct JobMetadata
 {
     Language srclang, lang;
@@ -70,7 +73,7 @@ class Worker
 {
 public:
     Worker(const JobMetadata& meta, std::shared_ptr<QAChecker> checker)
-        : m_metadata(meta), m_checker(checker), m_completed(false) {}
+        : m_metadata(meta), m_checker(checker), m_completed(false), m_inflight(0) {}
     virtual ~Worker() {}
 
     /// Add another item for processing
@@ -79,7 +82,7 @@ public:
         std::lock_guard lock(m_mutex);
         if (m_completed)
             return;
-        m_queue.push_back(item);
+        m_queue.push_back({item, Clock::now()});
     }
 
     /**
@@ -96,7 +99,7 @@ public:
     bool is_finished() const
     {
         std::lock_guard lock(m_mutex);
-        return m_completed && m_queue.empty();
+        return m_completed && m_queue.empty() && m_inflight == 0;
     }
 
     /**
@@ -114,10 +117,48 @@ public:
     /// Assignable next worker to process items this worker couldn't handle
     Worker *next_worker = nullptr;
 
+    /// Position of the worker in the chain of next_worker workers, for instrumentation
+    int stage = 0;
+
     /// Assignable stats collector for processed items
     std::shared_ptr<Stats> stats;
 
+    /// Assignable receiver of finished items, for incremental UI updates
+    std::shared_ptr<ResultsStream> results;
+
 protected:
+    /**
+        Takes next item from the queue, or returns nullptr if the queue is empty.
+
+        Each returned item is considered to be in flight until item_done() is
+        called for it.
+     */
+    CatalogItemPtr pop_item()
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_queue.empty())
+            return nullptr;
+
+        auto& front = m_queue.front();
+        if (stats)
+            stats->queue_wait.add(Clock::now() - front.queued);
+        auto dt = std::move(front.item);
+        m_queue.pop_front();
+        m_inflight++;
+        return dt;
+    }
+
+    void item_done()
+    {
+        m_inflight--;
+    }
+
+    size_t queue_size() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_queue.size();
+    }
+
     ResType process_results(CatalogItemPtr dt, unsigned index, const SuggestionsList& results)
     {
         if (results.empty())
@@ -150,7 +191,12 @@ protected:
         dt->SetFuzzy(isFuzzy);
 
         if (m_checker)
+        {
+            auto start = Clock::now();
             m_checker->Check(dt);
+            if (stats)
+                stats->qa_check.add(Clock::now() - start);
+        }
 
         return res.IsExactMatch() ? ResType::Exact : ResType::Fuzzy;
     }
@@ -171,23 +217,40 @@ protected:
     JobMetadata m_metadata;
     std::shared_ptr<QAChecker> m_checker;
 
+    struct QueuedItem
+    {
+        CatalogItemPtr item;
+        Clock::time_point queued;
+    };
+
     mutable std::mutex m_mutex;
-    std::deque<CatalogItemPtr> m_queue;
+    std::deque<QueuedItem> m_queue;
     std::atomic<bool> m_completed;
+    std::atomic<int> m_inflight;
 };
 
 
-class LocalDBWorker : public Worker
+/**
+ Worker querying the local TM.
+
+ Doesn't own any threads; instead, it schedules runners on the shared background
+ executor and adapts their number to the amount of remaining work and to measured
+ TM query latency: a handful of strings is processed by one or two runners that
+ start immediately, large jobs grow to saturate the machine, and surplus runners
+ retire as the queue drains.
+ */
+class LocalDBWorker : public Worker, public std::enable_shared_from_this<LocalDBWorker>
 {
 public:
     LocalDBWorker(const JobMetadata& meta, std::shared_ptr<QAChecker> checker)
-        : Worker(meta, checker), m_tm(TranslationMemory::Get())
+        : Worker(meta, checker),
+          m_tm(TranslationMemory::Get()),
+          m_scheduled(0), m_running(0), m_target(0),
+          m_queriesTime(0), m_queriesCount(0)
     {
-        const auto nthreads = std::clamp(std::thread::hardware_concurrency(), 4u, 16u);
-        for (unsigned i = 0; i < nthreads; ++i)
-        {
-            m_threads.create_thread([this]{ thread_worker(); });
-        }
+        const unsigned cores = std::max(std::thread::hardware_concurrency(), 1u);
+        m_maxCpuBound = cores;
+        m_maxIOBound = std::clamp(2 * cores, 4u, 16u);
     }
 
     bool pump(dispatch::cancellation_token_ptr cancellation_token) override
@@ -195,105 +258,255 @@ public:
         if (cancellation_token->is_cancelled())
         {
             clear_queue();
-            // fall through to wait for threads to finish and exit
+            // fall through to wait for runners to finish and exit
         }
 
         if (is_finished())
-        {
-            m_threads.join_all();
             return false;
-        }
+
+        schedule_runners();
+
+        // Guarantee forward progress even if the shared executor is saturated
+        // (e.g. by the task that called us) and none of our runners got to run:
+        if (m_running == 0)
+            process_next_item();
 
         return true;
     }
 
 private:
-    void thread_worker()
+    /// Runners should have at least this much work to be worth the overhead
+    static constexpr auto MIN_WORK_PER_RUNNER = 50ms;
+    /// Number of items per runner used before any latency measurement is available
+    static const size_t INITIAL_ITEMS_PER_RUNNER = 8;
+    /// Query latency above which the TM is considered I/O-bound rather than CPU-bound
+    static constexpr auto IO_BOUND_LATENCY = 2ms;
+
+    /// Computes ideal number of runners for the remaining work
+    unsigned compute_target_runners() const
     {
-        CatalogItemPtr dt;
+        const size_t pending = queue_size() + m_inflight;
+        if (pending == 0)
+            return 0;
 
-        while (true)
+        const int64_t count = m_queriesCount;
+        if (count == 0)
         {
-            // pop one item of work:
-            {
-                std::lock_guard lock(m_mutex);
-                if (m_queue.empty())
-                {
-                    if (m_completed)
-                    {
-                        break;  // no more work to do
-                    }
-                    else
-                    {
-                        std::this_thread::yield();
-                        continue; // wait for more work to be added
-                    }
-                }
+            // no measurements yet, be moderate:
+            size_t n = (pending + INITIAL_ITEMS_PER_RUNNER - 1) / INITIAL_ITEMS_PER_RUNNER;
+            return (unsigned)std::min<size_t>(n, m_maxCpuBound);
+        }
+
+        const auto latency = std::chrono::microseconds(m_queriesTime / count);
+        const unsigned limit = latency >= IO_BOUND_LATENCY ? m_maxIOBound : m_maxCpuBound;
+        const auto work = latency * pending;
+        size_t n = std::max<size_t>(1, work / MIN_WORK_PER_RUNNER);
+        return (unsigned)std::min<size_t>(n, limit);
+    }
+
+    void schedule_runners()
+    {
+        m_target = compute_target_runners();
+
+        while (m_scheduled < m_target)
+        {
+            m_scheduled++;
+            dispatch::async([self = shared_from_this()]{ self->runner(); });
+        }
+    }
+
+    void runner()
+    {
+        m_running++;
 
-                dt = std::move(m_queue.front());
-                m_queue.pop_front();
+        auto waitStart = Clock::now();
+        while (!try_retire())
+        {
+            if (!process_next_item(waitStart))
+            {
+                m_scheduled--;
+                break;
             }
+            waitStart = Clock::now();
+        }
+
+        m_running--;
+    }
+
+    /// Shrinks the pool by one runner if there are more than needed
+    bool try_retire()
+    {
+        unsigned current = m_scheduled;
+        while (current > m_target)
+        {
+            if (m_scheduled.compare_exchange_weak(current, current - 1))
+                return true;
+        }
+        return false;
+    }
+
+    bool process_next_item(Clock::time_point waitStart = Clock::now())
+    {
+        auto dt = pop_item();
+        if (!dt)
+            return false;
+
+        if (stats)
+            stats->lock_wait.add(Clock::now() - waitStart);
+
+        try
+        {
+            process_item(dt);
+        }
+        catch (...)
+        {
+            item_done();
+            if (stats)
+                stats->errors++;
+            wxLogError("%s", DescribeCurrentException());
+            return true;
+        }
+
+        item_done();
+        return true;
+    }
+
+    void process_item(CatalogItemPtr dt)
+    {
+        const auto processingStart = Clock::now();
 
-            auto results = m_tm.Search(m_metadata.srclang, m_metadata.lang, str::to_wstring(dt->GetString()));
-            auto rt = process_results(dt, 0, results);
+        auto suggestions = search(dt->GetString());
+        auto rt = process_results(dt, 0, suggestions);
 
-            if (translated(rt) && dt->HasPlural())
+        if (translated(rt) && dt->HasPlural())
+        {
+            switch (m_metadata.nplurals)
             {
-                switch (m_metadata.nplurals)
+                case 2:  // "simple" English-like plurals
                 {
-                    case 2:  // "simple" English-like plurals
-                    {
-                        auto results_plural = m_tm.Search(m_metadata.srclang, m_metadata.lang, str::to_wstring(dt->GetPluralString()));
-                        process_results(dt, 1, results_plural);
-                    }
-                    case 1:  // nothing else to do
-                    default: // not supported
-                        break;
+                    auto suggestions_plural = search(dt->GetPluralString());
+                    process_results(dt, 1, suggestions_plural);
                 }
+                case 1:  // nothing else to do
+                default: // not supported
+                    break;
             }
+        }
 
-            if (next_worker)
+        if (stats && stage < Stats::MAX_STAGES)
+            stats->stages[stage].add(Clock::now() - processingStart);
+
+        if (next_worker)
+        {
+            if (!translated(rt))
             {
-                if (!translated(rt))
+                // no usable translation, request elsewhere
+                next_worker->upload(dt);
+                return;
+            }
+            else
+            {
+                // usable local translation, but try to find better quality elsewhere if possible
+                auto score = suggestions.front().score;
+                if (score < 0.95)
                 {
-                    // no usable translation, request elsewhere
                     next_worker->upload(dt);
-                    continue;
-                }
-                else
-                {
-                    // usable local translation, but try to find better quality elsewhere if possible
-                    auto score = results.front().score;
-                    if (score < 0.95)
-                    {
-                        next_worker->upload(dt);
-                        continue;
-                    }
+                    return;
                 }
             }
+        }
 
-            // if the item wasn't passed to next worker, count it
-            if (stats)
-            {
-                stats->inc_processed();
-                stats->add(rt);
-            }
+        // if the item wasn't passed to next worker, count it
+        if (stats)
+        {
+            stats->inc_processed();
+            stats->add(rt);
         }
+
+        if (results && translated(rt))
+            results->push(dt);
+    }
+
+    SuggestionsList search(const wxString& text)
+    {
+        auto start = Clock::now();
+        auto suggestions = m_tm.Search(m_metadata.srclang, m_metadata.lang, str::to_wstring(text));
+        auto duration = Clock::now() - start;
+
+        m_queriesTime += std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        m_queriesCount++;
+        if (stats)
+            stats->tm_search.add(duration);
+
+        return suggestions;
     }
 
 private:
-    boost::thread_group m_threads;
     TranslationMemory& m_tm;
+    unsigned m_maxCpuBound, m_maxIOBound;
+
+    std::atomic<unsigned> m_scheduled;  // runners submitted to the executor and not yet finished
+    std::atomic<unsigned> m_running;    // runners actually executing
+    std::atomic<unsigned> m_target;     // desired number of runners
+
+    std::atomic<int64_t> m_queriesTime; // total TM query time, in microseconds
+    std::atomic<int64_t> m_queriesCount;
 };
 
 
 } // anonymous namespace
 
 
+std::string Stats::timing_report() const
+{
+    auto timing = [](const Timing& t)
+    {
+        return json{{"count", t.count.load()}, {"total_ms", t.total_ms()}, {"avg_ms", t.average_ms()}};
+    };
+
+    json stages_data = json::array();
+    for (auto& st: stages)
+    {
+        if (st.count)
+            stages_data.push_back(timing(st));
+    }
+
+    json j;
+    j["elapsed_ms"] = elapsed_ms.load();
+    j["input_strings"] = input_strings_count.load();
+    j["matched"] = matched.load();
+    j["queries_per_second"] = queries_per_second();
+    j["queue_wait"] = timing(queue_wait);
+    j["lock_wait"] = timing(lock_wait);
+    j["tm_search"] = timing(tm_search);
+    j["qa_check"] = timing(qa_check);
+    j["stages"] = stages_data;
+    return j.dump();
+}
+
+
+void ResultsStream::flush()
+{
+    CatalogItemArray batch;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_pending.empty())
+            return;
+        batch.swap(m_pending);
+    }
+
+    dispatch::on_main([handler = m_handler, batch = std::move(batch)]
+    {
+        handler(batch);
+    });
+}
+
+
 std::shared_ptr<Stats> PreTranslateCatalog(CatalogPtr catalog,
                                            const CatalogItemArray& range,
                                            PreTranslateOptions options,
-                                           dispatch::cancellation_token_ptr cancellation_token)
+                                           dispatch::cancellation_token_ptr cancellation_token,
+                                           std::shared_ptr<ResultsStream> results)
 {
     wxStopWatch sw;
 
@@ -317,10 +530,13 @@ std::shared_ptr<Stats> PreTranslateCatalog(CatalogPtr catalog,
 
     auto qa_checker = QAChecker::GetFor(*catalog);
 
-    auto worker_local = use_local_tm ? std::make_unique<LocalDBWorker>(metadata, qa_checker) : nullptr;
+    auto worker_local = use_local_tm ? std::make_shared<LocalDBWorker>(metadata, qa_checker) : nullptr;
 
     if (worker_local)
+    {
         worker_local->stats = stats;
+        worker_local->results = results;
+    }
 
     Worker *worker_ingest = worker_local.get();
 
@@ -339,14 +555,16 @@ std::shared_ptr<Stats> PreTranslateCatalog(CatalogPtr catalog,
     Progress progress(stats->input_strings_count, top_progress, 1);
     progress.message(_(L"Pre-translating…"));
 
+    // don't flood the main thread with tiny batches of updates:
+    const long results_flush_interval = 200; // ms
+    wxStopWatch results_sw;
+
     int last_matched = 0;
     bool more_work = true;
     while (more_work)
     {
         try
         {
-            std::this_thread::sleep_for(10ms);
-
             // pump the workers:
             more_work = false;
             if (worker_local)
@@ -368,6 +586,15 @@ std::shared_ptr<Stats> PreTranslateCatalog(CatalogPtr catalog,
                 progress.message(wxString::Format(wxPLURAL("Pre-translated %u string", "Pre-translated %u strings", last_matched), last_matched));
             }
             progress.set(stats->input_strings_processed);
+
+            if (results && results_sw.Time() >= results_flush_interval)
+            {
+                results->flush();
+                results_sw.Start();
+            }
+
+            if (more_work)
+                std::this_thread::sleep_for(10ms);
         }
         catch (...)
         {
@@ -377,7 +604,12 @@ std::shared_ptr<Stats> PreTranslateCatalog(CatalogPtr catalog,
         }
     }
 
+    if (results)
+        results->flush();
+
+    stats->elapsed_ms = sw.Time();
     wxLogTrace("poedit", "Pre-translation completed in %ld ms", sw.Time());
+    wxLogTrace("poedit.pretranslate", "%s", stats->timing_report());
     return stats;
 }
 
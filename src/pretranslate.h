@@ -30,8 +30,10 @@
 #include "concurrency.h"
 
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <mutex>
 
 
 
@@ -67,6 +69,23 @@ enum class ResType
 inline bool translated(ResType r) { return r >= ResType::Fuzzy; }
 
 
+/// Accumulated duration of some repeated operation, summed across threads
+struct Timing
+{
+    std::atomic<int64_t> total_us = 0;
+    std::atomic<int> count = 0;
+
+    void add(std::chrono::steady_clock::duration d)
+    {
+        total_us.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(d).count(), std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    double total_ms() const { return total_us / 1000.0; }
+    double average_ms() const { return count ? total_ms() / count : 0.0; }
+};
+
+
 struct Stats
 {
     std::atomic<int> input_strings_count = 0;
@@ -77,6 +96,29 @@ struct Stats
     std::atomic<int> fuzzy = 0;
     std::atomic<int> errors = 0;
 
+    // Performance instrumentation:
+
+    /// Max. number of workers chained through next_worker that are timed
+    static const int MAX_STAGES = 4;
+
+    Timing queue_wait;          ///< time items spent queued before processing
+    Timing lock_wait;           ///< time spent waiting for work queue's lock or for more work
+    Timing tm_search;           ///< individual TM queries
+    Timing qa_check;            ///< QA checks of pre-translated items
+    Timing stages[MAX_STAGES];  ///< processing of items by n-th worker in the chain
+
+    /// Wall-clock duration of the whole job
+    std::atomic<int64_t> elapsed_ms = 0;
+
+    /// Throughput of TM queries over the whole job
+    double queries_per_second() const
+    {
+        return elapsed_ms ? tm_search.count * 1000.0 / elapsed_ms : 0.0;
+    }
+
+    /// Returns timing data in machine-readable (JSON) form
+    std::string timing_report() const;
+
     explicit operator bool() const { return matched > 0; }
 
     void inc_processed(int delta = 1)
@@ -96,11 +138,48 @@ struct Stats
     }
 };
 
+/**
+    Stream of pre-translated items from worker threads to the main thread.
+
+    Workers push() items as soon as they are done with them and the items are
+    periodically delivered, in batches, to the handler on the main thread. This
+    lets the UI refresh affected rows while a long job is still running.
+ */
+class ResultsStream
+{
+public:
+    typedef std::function<void(const CatalogItemArray&)> Handler;
+
+    explicit ResultsStream(Handler handler) : m_handler(std::move(handler)) {}
+
+    /// Add a finished item to the stream. Can be called from any thread.
+    void push(CatalogItemPtr item)
+    {
+        std::lock_guard lock(m_mutex);
+        m_pending.push_back(std::move(item));
+    }
+
+    /// Send all pending items, if any, to the handler on the main thread.
+    void flush();
+
+private:
+    Handler m_handler;
+    std::mutex m_mutex;
+    CatalogItemArray m_pending;
+};
+
+/**
+    Pre-translate items in @a range.
+
+    If @a results is provided, modified items are streamed into it while
+    the job is running.
+ */
 std::shared_ptr<Stats>
 PreTranslateCatalog(CatalogPtr catalog,
                     const CatalogItemArray& range,
                     PreTranslateOptions options,
-                    dispatch::cancellation_token_ptr cancellation_token);
+                    dispatch::cancellation_token_ptr cancellation_token,
+                    std::shared_ptr<ResultsStream> results = nullptr);
 
 } // namespace pretranslate
 
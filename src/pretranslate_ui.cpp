@@ -48,6 +48,7 @@
 #include <wx/sizer.h>
 #include <wx/statbmp.h>
 #include <wx/statline.h>
+#include <wx/weakref.h>
 #include <wx/windowptr.h>
 
 #include <atomic>
@@ -58,18 +59,34 @@
 namespace
 {
 
-void PreTranslateCatalog(wxWindow *window,
+void PreTranslateCatalog(wxWindow *window, PoeditListCtrl *list,
                          CatalogPtr catalog, const CatalogItemArray& range,
                          const PreTranslateOptions& options,
-                         std::function<void()> completionHandler)
+                         std::function<void()> completionHandler,
+                         std::function<void()> partialResultsHandler)
 {
     auto changesMade = std::make_shared<bool>(false);
 
+    // refresh rows as they are pre-translated, without waiting for the whole job:
+    std::shared_ptr<pretranslate::ResultsStream> results;
+    if (list)
+    {
+        wxWeakRef<PoeditListCtrl> weakList(list);
+        results = std::make_shared<pretranslate::ResultsStream>([weakList,partialResultsHandler](const CatalogItemArray& items)
+        {
+            if (!weakList)
+                return;
+            weakList->RefreshCatalogItems(items);
+            if (partialResultsHandler)
+                partialResultsHandler();
+        });
+    }
+
     auto cancellation = std::make_shared<dispatch::cancellation_token>();
     wxWindowPtr<ProgressWindow> progress(new ProgressWindow(window, _(L"Pre-translating…"), cancellation));
     progress->RunTaskThenDo([=]()
     {
-        auto stats = pretranslate::PreTranslateCatalog(catalog, range, options, cancellation);
+        auto stats = pretranslate::PreTranslateCatalog(catalog, range, options, cancellation, results);
         *changesMade = stats->matched > 0;
 
         BackgroundTaskResult bg;
@@ -87,6 +104,12 @@ void PreTranslateCatalog(wxWindow *window,
 
             bg.details.emplace_back(_("Exact matches from TM"), wxNumberFormatter::ToString((long)stats->exact));
             bg.details.emplace_back(_("Approximate matches from TM"), wxNumberFormatter::ToString((long)stats->fuzzy));
+
+            if (stats->tm_search.count)
+            {
+                bg.details.emplace_back(_("TM queries per second"), wxNumberFormatter::ToString(stats->queries_per_second(), 1));
+                bg.details.emplace_back(_("Average TM query time"), wxString::Format(_("%s ms"), wxNumberFormatter::ToString(stats->tm_search.average_ms(), 1)));
+            }
         }
         else
         {
@@ -113,13 +136,15 @@ void PreTranslateCatalog(wxWindow *window,
 } // anonymous namespace
 
 
-void PreTranslateCatalogAuto(wxWindow *window, CatalogPtr catalog, const PreTranslateOptions& options, std::function<void()> onChangesMade)
+void PreTranslateCatalogAuto(wxWindow *window, PoeditListCtrl *list, CatalogPtr catalog, const PreTranslateOptions& options,
+                             std::function<void()> onChangesMade, std::function<void()> onPartialResults)
 {
-    PreTranslateCatalog(window, catalog, catalog->items(), options, std::move(onChangesMade));
+    PreTranslateCatalog(window, list, catalog, catalog->items(), options, std::move(onChangesMade), std::move(onPartialResults));
 }
 
 
-void PreTranslateWithUI(wxWindow *window, PoeditListCtrl *list, CatalogPtr catalog, std::function<void()> onChangesMade)
+void PreTranslateWithUI(wxWindow *window, PoeditListCtrl *list, CatalogPtr catalog,
+                        std::function<void()> onChangesMade, std::function<void()> onPartialResults)
 {
     if (catalog->UsesSymbolicIDsForSource())
     {
@@ -215,7 +240,7 @@ void PreTranslateWithUI(wxWindow *window, PoeditListCtrl *list, CatalogPtr catal
         noFuzzy->SetValue(settings.exactNotFuzzy);
     }
 
-    dlg->ShowWindowModalThenDo([catalog,window,list,onlyExact,noFuzzy,onChangesMade,dlg](int retcode)
+    dlg->ShowWindowModalThenDo([catalog,window,list,onlyExact,noFuzzy,onChangesMade,onPartialResults,dlg](int retcode)
     {
         if (retcode != wxID_OK)
             return;
@@ -233,11 +258,11 @@ void PreTranslateWithUI(wxWindow *window, PoeditListCtrl *list, CatalogPtr catal
 
         if (list->HasMultipleSelection())
         {
-            PreTranslateCatalog(window, catalog, list->GetSelectedCatalogItems(), options, std::move(onChangesMade));
+            PreTranslateCatalog(window, list, catalog, list->GetSelectedCatalogItems(), options, std::move(onChangesMade), std::move(onPartialResults));
         }
         else
         {
-            PreTranslateCatalog(window, catalog, catalog->items(), options, std::move(onChangesMade));
+            PreTranslateCatalog(window, list, catalog, catalog->items(), options, std::move(onChangesMade), std::move(onPartialResults));
         }
     });
 }
@@ -36,12 +36,17 @@
 /**
     Pre-translate all items in the catalog w/o UI.
 
+    Rows of @a list (if not null) are refreshed as they are pre-translated and
+    @a onPartialResults is called after each such batch of changes.
+
     Calls @a onChangesMade if any changes were made.
  */
 void PreTranslateCatalogAuto(wxWindow *window,
+                             PoeditListCtrl *list,
                              CatalogPtr catalog,
                              const PreTranslateOptions& options,
-                             std::function<void()> onChangesMade);
+                             std::function<void()> onChangesMade,
+                             std::function<void()> onPartialResults = nullptr);
 
 /**
     Show UI for choosing pre-translation choices, then proceed with
@@ -51,10 +56,13 @@ void PreTranslateCatalogAuto(wxWindow *window,
     @param list     List to take selection from
     @param catalog  Catalog to translate
 
-    Calls @a onChangesMade if any changes were made.
+    Calls @a onChangesMade if any changes were made. Rows of @a list are
+    refreshed while the job is running and @a onPartialResults is called
+    after each batch of them.
  */
 void PreTranslateWithUI(wxWindow *window, PoeditListCtrl *list,
                         CatalogPtr catalog,
-                        std::function<void()> onChangesMade);
+                        std::function<void()> onChangesMade,
+                        std::function<void()> onPartialResults = nullptr);
 
 #endif // Poedit_pretranslate_ui_h
@@ -46,6 +46,22 @@ namespace pugi
 constexpr auto PUGI_PARSE_FLAGS = parse_full | parse_ws_pcdata | parse_fragment;
 
 
+/**
+    Load XML document from file.
+
+    Unlike passing fn_str() to xml_document::load_file(), this handles
+    filenames not representable in the ANSI codepage on Windows.
+ */
+inline xml_parse_result load_file(xml_document& doc, const wxString& filename, unsigned int options = PUGI_PARSE_FLAGS)
+{
+#ifdef __WXMSW__
+    return doc.load_file(filename.wc_str(), options);
+#else
+    return doc.load_file(filename.fn_str(), options);
+#endif
+}
+
+
 /// Helper function to set an attribute on a node, creating it if it doesn't exist.
 inline xml_attribute attribute(xml_node node, const char *name)
 {
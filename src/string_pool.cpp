@@ -0,0 +1,94 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "string_pool.h"
+
+#include <functional>
+#include <string_view>
+
+
+const wxString& StringPool::EmptyString()
+{
+    static const wxString empty;
+    return empty;
+}
+
+const wxArrayString& StringPool::EmptyArray()
+{
+    static const wxArrayString empty;
+    return empty;
+}
+
+
+size_t StringPool::HashOf(const wxString& s)
+{
+    return std::hash<std::wstring_view>()(std::wstring_view(s.wc_str(), s.length()));
+}
+
+size_t StringPool::HashOf(const wxArrayString& arr)
+{
+    size_t h = arr.size();
+    for (auto& s: arr)
+        h = h * 31 + HashOf(s);
+    return h;
+}
+
+
+InternedString StringPool::Intern(const wxString& s)
+{
+    if (s.empty())
+        return nullptr;
+
+    const Key<wxString> key{&s, HashOf(s)};
+    auto& shard = ShardFor(key.hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto i = shard.strings.find(key);
+    if (i != shard.strings.end())
+        return i->second;
+
+    auto value = std::make_shared<const wxString>(s);
+    shard.strings.emplace(Key<wxString>{value.get(), key.hash}, value);
+    return value;
+}
+
+
+InternedStringArray StringPool::Intern(const wxArrayString& arr)
+{
+    if (arr.empty())
+        return nullptr;
+
+    const Key<wxArrayString> key{&arr, HashOf(arr)};
+    auto& shard = ShardFor(key.hash);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto i = shard.arrays.find(key);
+    if (i != shard.arrays.end())
+        return i->second;
+
+    auto value = std::make_shared<const wxArrayString>(arr);
+    shard.arrays.emplace(Key<wxArrayString>{value.get(), key.hash}, value);
+    return value;
+}
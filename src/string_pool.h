@@ -0,0 +1,121 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_string_pool_h
+#define Poedit_string_pool_h
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+
+/// Immutable string value, possibly shared by many catalog items; null if empty.
+typedef std::shared_ptr<const wxString> InternedString;
+
+/// Immutable array of strings, possibly shared by many catalog items; null if empty.
+typedef std::shared_ptr<const wxArrayString> InternedStringArray;
+
+
+/**
+    Pool of interned strings.
+
+    Catalog items repeat many of their secondary values (flags, extracted
+    comments, references, contexts) across entries. Interning them through
+    a pool used when loading the catalog stores each distinct value only once.
+    Interned values are reference-counted, so they remain valid after the pool
+    is destroyed.
+
+    The pool is thread-safe, so that it can be used by parallel parsers. It is
+    split into independently locked shards selected by the value's hash, so
+    that concurrent callers rarely contend for the same lock.
+ */
+class StringPool
+{
+public:
+    StringPool() {}
+    StringPool(const StringPool&) = delete;
+
+    /// Returns shared instance of @a s.
+    InternedString Intern(const wxString& s);
+
+    /// Returns shared instance of @a arr.
+    InternedStringArray Intern(const wxArrayString& arr);
+
+    /// Wraps a value without interning it, for use when there's no pool.
+    static InternedString Wrap(const wxString& s)
+        { return s.empty() ? nullptr : std::make_shared<const wxString>(s); }
+    static InternedStringArray Wrap(const wxArrayString& arr)
+        { return arr.empty() ? nullptr : std::make_shared<const wxArrayString>(arr); }
+
+    /// Accesses interned value, which may be null.
+    static const wxString& Get(const InternedString& s)
+        { return s ? *s : EmptyString(); }
+    static const wxArrayString& Get(const InternedStringArray& arr)
+        { return arr ? *arr : EmptyArray(); }
+
+private:
+    static const wxString& EmptyString();
+    static const wxArrayString& EmptyArray();
+
+    static size_t HashOf(const wxString& s);
+    static size_t HashOf(const wxArrayString& arr);
+
+    // Keys point to the values they map to and carry precomputed hash, so
+    // that hashing happens outside of the shard's lock.
+    template<typename T>
+    struct Key
+    {
+        const T *value;
+        size_t hash;
+    };
+    struct KeyHash
+    {
+        template<typename T>
+        size_t operator()(const Key<T>& k) const { return k.hash; }
+    };
+    struct KeyEqual
+    {
+        template<typename T>
+        bool operator()(const Key<T>& a, const Key<T>& b) const { return a.hash == b.hash && *a.value == *b.value; }
+    };
+
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<Key<wxString>, InternedString, KeyHash, KeyEqual> strings;
+        std::unordered_map<Key<wxArrayString>, InternedStringArray, KeyHash, KeyEqual> arrays;
+    };
+
+    static constexpr size_t SHARD_COUNT = 64;
+    Shard& ShardFor(size_t hash) { return m_shards[(hash ^ (hash >> 29)) % SHARD_COUNT]; }
+
+    std::array<Shard, SHARD_COUNT> m_shards;
+};
+
+#endif // Poedit_string_pool_h
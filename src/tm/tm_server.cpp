@@ -0,0 +1,445 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "tm_server.h"
+
+#include "transmem.h"
+
+#include "concurrency.h"
+#include "edapp.h"
+#include "errors.h"
+#include "json.h"
+#include "str_helpers.h"
+
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+#include <wx/socket.h>
+
+#include <boost/thread/thread.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+
+// How often blocked threads check for server shutdown:
+const unsigned long POLL_INTERVAL_MS = 250;
+
+// How often a connection checks for finished responses while requests are in flight:
+const unsigned long RESPONSE_POLL_INTERVAL_MS = 2;
+
+// Refuse absurdly long lines instead of buffering them indefinitely:
+const size_t MAX_REQUEST_SIZE = 16 * 1024 * 1024;
+
+
+class SubstringCollector : public TranslationMemory::IOInterface
+{
+public:
+    void Insert(const Language& /*srclang*/, const Language& /*lang*/,
+                const std::wstring& source, const std::wstring& trans,
+                time_t /*creationTime*/) override
+    {
+        results.push_back({{"source", source}, {"translation", trans}});
+    }
+
+    json results = json::array();
+};
+
+
+Language ParseLanguage(const json& req, const char *key)
+{
+    auto lang = Language::TryParse(get_value(req, key, ""));
+    if (!lang.IsValid())
+        BOOST_THROW_EXCEPTION(Exception(wxString::Format("Invalid or missing \"%s\" value.", key)));
+    return lang;
+}
+
+std::wstring ParseText(const json& req, const char *key)
+{
+    auto i = req.find(key);
+    if (i == req.end() || !i->is_string())
+        BOOST_THROW_EXCEPTION(Exception(wxString::Format("Invalid or missing \"%s\" value.", key)));
+    return str::to_wstring(i->get<std::string>());
+}
+
+
+struct SocketDeleter
+{
+    void operator()(wxSocketBase *s) const { s->Destroy(); }
+};
+
+typedef std::shared_ptr<wxSocketBase> SocketPtr;
+
+
+/**
+    Responses completed by worker tasks, waiting to be written out.
+
+    wxSocket doesn't support reading and writing from different threads at
+    the same time, so workers never touch the socket; only the connection's
+    own thread does, and it picks finished responses from here.
+ */
+class ResponseQueue
+{
+public:
+    void push(const json& response)
+    {
+        auto data = response.dump();
+        data += '\n';
+
+        std::lock_guard lock(m_mutex);
+        m_pending.push_back(std::move(data));
+    }
+
+    std::vector<std::string> take()
+    {
+        std::vector<std::string> out;
+        std::lock_guard lock(m_mutex);
+        out.swap(m_pending);
+        return out;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::string> m_pending;
+};
+
+
+/// Compares secrets in time independent of where they differ.
+bool ConstantTimeEquals(const std::string& a, const std::string& b)
+{
+    if (a.size() != b.size())
+        return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+        diff |= (unsigned char)(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+
+} // anonymous namespace
+
+
+class TranslationMemoryServer::impl : public std::enable_shared_from_this<impl>
+{
+public:
+    impl(unsigned short port, std::function<void()> onShutdownRequested)
+        : m_onShutdownRequested(std::move(onShutdownRequested)),
+          m_stopped(false)
+    {
+        // required for use of sockets from worker threads:
+        wxSocketBase::Initialize();
+
+        wxIPV4address addr;
+        addr.LocalHost();
+        addr.Service(port);
+
+        m_server.reset(new wxSocketServer(addr, wxSOCKET_BLOCK | wxSOCKET_REUSEADDR));
+        if (!m_server->IsOk())
+            BOOST_THROW_EXCEPTION(Exception(wxString::Format(_("Cannot listen on port %d."), (int)port)));
+
+        create_token_file(port);
+
+        // open the TM now, so that the first query doesn't pay for it:
+        TranslationMemory::Get();
+
+        wxLogTrace("poedit", "TM server listening on port %d", (int)port);
+    }
+
+    void start()
+    {
+        auto self = shared_from_this();
+        m_acceptThread = boost::thread([self]{ self->accept_loop(); });
+    }
+
+    void stop()
+    {
+        m_stopped.store(true, std::memory_order_release);
+        if (m_acceptThread.joinable())
+            m_acceptThread.join();
+        m_server.reset();
+
+        if (!m_tokenFile.empty())
+            wxRemoveFile(m_tokenFile);
+    }
+
+private:
+    bool stopped() const { return m_stopped.load(std::memory_order_acquire); }
+
+    /**
+        Generates the secret clients must present and stores it in a file
+        readable only by the current user. The port is reachable by any
+        local user, the file isn't.
+     */
+    void create_token_file(unsigned short port)
+    {
+        m_token = boost::uuids::to_string(boost::uuids::random_generator()());
+
+        const wxString filename = PoeditApp::GetCacheDir("TM") + wxFILE_SEP_PATH + wxString::Format("server-%d.token", (int)port);
+        wxFileName::Mkdir(wxFileName(filename).GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+        // wxFile::Create() only applies permissions to newly created files:
+        wxRemoveFile(filename);
+
+        wxFile f;
+        if (!f.Create(filename, /*overwrite=*/false, wxS_IRUSR | wxS_IWUSR) ||
+            f.Write(m_token.data(), m_token.size()) != m_token.size() ||
+            !f.Close())
+        {
+            wxRemoveFile(filename);
+            BOOST_THROW_EXCEPTION(Exception(wxString::Format(_(L"Cannot write authentication token to “%s”."), filename)));
+        }
+
+        m_tokenFile = filename;
+        wxLogMessage(_(L"Authentication token for the TM server is in “%s”."), filename);
+    }
+
+    bool authenticate(const std::string& line, json& response)
+    {
+        response = json{{"id", nullptr}};
+        try
+        {
+            auto req = json::parse(line);
+            if (req.contains("id"))
+                response["id"] = req["id"];
+            if (get_value(req, "method", "") == "auth" && ConstantTimeEquals(get_value(req, "token", ""), m_token))
+            {
+                response["result"] = true;
+                return true;
+            }
+        }
+        catch (...)
+        {
+        }
+
+        response["error"] = "Authentication required.";
+        return false;
+    }
+
+    void accept_loop()
+    {
+        // connections are owned by this thread, so that stop() can simply join it:
+        boost::thread_group connections;
+
+        while (!stopped())
+        {
+            if (!m_server->WaitForAccept(0, POLL_INTERVAL_MS))
+                continue;
+
+            SocketPtr sock(m_server->Accept(false), SocketDeleter());
+            if (!sock)
+                continue;
+
+            auto self = shared_from_this();
+            connections.create_thread([self, sock]{ self->connection_loop(sock); });
+        }
+
+        connections.join_all();
+    }
+
+    void connection_loop(SocketPtr sock)
+    {
+        // All I/O on the socket happens on this thread, see ResponseQueue:
+        sock->SetFlags(wxSOCKET_BLOCK | wxSOCKET_NOWAIT_READ);
+
+        auto responses = std::make_shared<ResponseQueue>();
+        size_t inFlight = 0;
+        bool authenticated = false;
+        bool closed = false;
+        std::string buffer;
+        char chunk[16384];
+
+        auto flush = [&]
+        {
+            for (auto& data: responses->take())
+            {
+                --inFlight;
+                if (sock->IsConnected())
+                    sock->Write(data.data(), (wxUint32)data.size());
+            }
+        };
+
+        // after the client closes its side, still deliver responses to its requests:
+        while (!stopped() && !(closed && inFlight == 0))
+        {
+            flush();
+
+            const auto timeout = inFlight ? RESPONSE_POLL_INTERVAL_MS : POLL_INTERVAL_MS;
+            if (closed)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+                continue;
+            }
+            if (!sock->WaitForRead(0, timeout))
+                continue;
+
+            sock->Read(chunk, sizeof(chunk));
+            auto count = sock->LastReadCount();
+            if (count == 0)
+            {
+                closed = true;  // connection closed by the client
+                continue;
+            }
+            buffer.append(chunk, count);
+
+            size_t eol;
+            while ((eol = buffer.find('\n')) != std::string::npos)
+            {
+                std::string line(buffer, 0, eol);
+                buffer.erase(0, eol + 1);
+                if (line.empty() || line == "\r")
+                    continue;
+
+                if (!authenticated)
+                {
+                    json response;
+                    authenticated = authenticate(line, response);
+                    send(*sock, response);
+                    if (!authenticated)
+                        return;
+                    continue;
+                }
+
+                inFlight++;
+                auto self = shared_from_this();
+                dispatch::async([self, responses, line = std::move(line)]
+                {
+                    responses->push(self->handle_request(line));
+                });
+            }
+
+            if (buffer.size() > MAX_REQUEST_SIZE)
+            {
+                send(*sock, json{{"id", nullptr}, {"error", "Request too long."}});
+                break;
+            }
+        }
+
+        // Requests being handled use the TM, which is destroyed after the server
+        // is stopped, so they must finish before this thread (joined by stop()) does:
+        while (inFlight)
+        {
+            flush();
+            if (inFlight)
+                std::this_thread::sleep_for(std::chrono::milliseconds(RESPONSE_POLL_INTERVAL_MS));
+        }
+    }
+
+    void send(wxSocketBase& sock, const json& response)
+    {
+        auto data = response.dump();
+        data += '\n';
+        if (sock.IsConnected())
+            sock.Write(data.data(), (wxUint32)data.size());
+    }
+
+    json handle_request(const std::string& line)
+    {
+        json response;
+        response["id"] = nullptr;
+
+        try
+        {
+            auto req = json::parse(line);
+            if (req.contains("id"))
+                response["id"] = req["id"];
+
+            auto& tm = TranslationMemory::Get();
+            const auto method = get_value(req, "method", "");
+
+            if (method == "search")
+            {
+                auto results = tm.Search(ParseLanguage(req, "srclang"), ParseLanguage(req, "lang"), ParseText(req, "source"));
+                json list = json::array();
+                for (auto& s: results)
+                    list.push_back({{"text", s.text}, {"score", s.score}, {"id", s.id}});
+                response["result"] = list;
+            }
+            else if (method == "search_substring")
+            {
+                SubstringCollector collector;
+                tm.SearchSubstring(collector, ParseLanguage(req, "srclang"), ParseLanguage(req, "lang"), ParseText(req, "source"));
+                response["result"] = collector.results;
+            }
+            else if (method == "insert")
+            {
+                tm.GetWriter()->Insert(ParseLanguage(req, "srclang"), ParseLanguage(req, "lang"),
+                                       ParseText(req, "source"), ParseText(req, "translation"));
+                response["result"] = true;
+            }
+            else if (method == "commit")
+            {
+                tm.GetWriter()->Commit();
+                response["result"] = true;
+            }
+            else if (method == "shutdown")
+            {
+                if (m_onShutdownRequested)
+                    dispatch::on_main(m_onShutdownRequested);
+                response["result"] = true;
+            }
+            else
+            {
+                BOOST_THROW_EXCEPTION(Exception(wxString::Format("Unknown method \"%s\".", method)));
+            }
+        }
+        catch (...)
+        {
+            response["error"] = str::to_utf8(DescribeCurrentException());
+        }
+
+        return response;
+    }
+
+private:
+    std::function<void()> m_onShutdownRequested;
+    std::unique_ptr<wxSocketServer, SocketDeleter> m_server;
+    std::atomic<bool> m_stopped;
+    boost::thread m_acceptThread;
+    std::string m_token;
+    wxString m_tokenFile;
+};
+
+
+TranslationMemoryServer::TranslationMemoryServer(unsigned short port, std::function<void()> onShutdownRequested)
+    : m_impl(std::make_shared<impl>(port, std::move(onShutdownRequested)))
+{
+    m_impl->start();
+}
+
+TranslationMemoryServer::~TranslationMemoryServer()
+{
+    m_impl->stop();
+}
@@ -0,0 +1,84 @@
+/*
+ *  This file is part of Poedit (https://poedit.net)
+ *
+ *  Copyright (C) 2026 Vaclav Slavik
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ *  all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ *  DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef Poedit_tm_server_h
+#define Poedit_tm_server_h
+
+#include <functional>
+#include <memory>
+
+
+/**
+    Serves the translation memory to other processes.
+
+    Keeps the TM open and answers queries on a loopback TCP port, so that
+    scripts or several Poedit instances can share one warm index instead of
+    each opening it separately.
+
+    The protocol is line-based JSON: every request is a single line with
+    a JSON object and every response is a line with a JSON object carrying
+    the same "id". Requests are processed concurrently, so responses may be
+    sent in different order than requests.
+
+    The port is reachable by any local user, so the first request on every
+    connection must authenticate with the token that the server writes, on
+    startup, to a file readable only by its own user ("server-<port>.token"
+    in Poedit's TM cache directory). Connections that don't are closed:
+
+        {"id": 0, "method": "auth", "token": "..."}
+
+    Supported requests after that:
+
+        {"id": 1, "method": "search", "srclang": "en", "lang": "cs", "source": "..."}
+        {"id": 2, "method": "search_substring", "srclang": "en", "lang": "cs", "source": "..."}
+        {"id": 3, "method": "insert", "srclang": "en", "lang": "cs", "source": "...", "translation": "..."}
+        {"id": 4, "method": "commit"}
+        {"id": 5, "method": "shutdown"}
+
+    Successful responses have a "result" key, failed ones have "error" with
+    description of the problem.
+ */
+class TranslationMemoryServer
+{
+public:
+    /**
+        Starts listening on loopback interface's @a port.
+
+        @a onShutdownRequested is called on the main thread when a client
+        sends the "shutdown" request.
+
+        Must be called from the main thread. Throws on failure.
+     */
+    TranslationMemoryServer(unsigned short port, std::function<void()> onShutdownRequested);
+
+    /// Stops the server, waiting for connections to close.
+    ~TranslationMemoryServer();
+
+private:
+    class impl;
+    std::shared_ptr<impl> m_impl;
+};
+
+#endif // Poedit_tm_server_h
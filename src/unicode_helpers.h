@@ -34,6 +34,9 @@
 
 #include <unicode/ucol.h>
 #include <unicode/ubrk.h>
+#include <unicode/utext.h>
+
+#include <string_view>
 
 
 #ifdef __WXMSW__
@@ -112,8 +115,13 @@ public:
     {
         if (m_bi)
             ubrk_close(m_bi);
+        if (m_utext)
+            utext_close(m_utext);
     }
 
+    BreakIterator(const BreakIterator&) = delete;
+    BreakIterator& operator=(const BreakIterator&) = delete;
+
     /**
      Set the text to process.
 
@@ -125,6 +133,18 @@ public:
         ubrk_setText(m_bi, text, -1, &err);
     }
 
+    /**
+     Set UTF-8 text to process. Returned indexes are byte offsets into it.
+
+     The lifetime of the text buffer must be longer than the lifetime of BreakIterator!
+     */
+    void set_text(std::string_view utf8)
+    {
+        UErrorCode err = U_ZERO_ERROR;
+        m_utext = utext_openUTF8(m_utext, utf8.data(), (int64_t)utf8.size(), &err);
+        ubrk_setUText(m_bi, m_utext, &err);
+    }
+
     /// Sets iterator to the beginning
     int32_t begin() { return ubrk_first(m_bi); }
     constexpr int32_t end() const { return UBRK_DONE; }
@@ -138,6 +158,7 @@ public:
 
 private:
     UBreakIterator *m_bi = nullptr;
+    UText *m_utext = nullptr;
 };
 
 
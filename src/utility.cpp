@@ -27,6 +27,7 @@
 
 #include <stdio.h>
 
+#include <wx/file.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/config.h>
@@ -41,8 +42,13 @@
 #ifdef __UNIX__
     #include <sys/types.h>
     #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
     #include <unistd.h>
 #endif
+#ifdef __WXMSW__
+    #include <wx/msw/wrapwin.h>
+#endif
 
 #include "str_helpers.h"
 
@@ -336,6 +342,95 @@ TempOutputFileFor::~TempOutputFileFor()
 #endif
 }
 
+MappedFile::MappedFile(const wxString& filename)
+{
+#if defined(__UNIX__)
+    int fd = open(filename.fn_str(), O_RDONLY);
+    if (fd != -1)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED)
+            {
+                m_data = static_cast<const char*>(addr);
+                m_size = (size_t)st.st_size;
+                m_mapped = m_ok = true;
+            }
+        }
+        close(fd);
+    }
+#elif defined(__WXMSW__)
+    HANDLE file = ::CreateFileW(filename.wc_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER size;
+        if (::GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        {
+            m_mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping)
+            {
+                void *addr = ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+                if (addr)
+                {
+                    m_data = static_cast<const char*>(addr);
+                    m_size = (size_t)size.QuadPart;
+                    m_mapped = m_ok = true;
+                }
+                else
+                {
+                    ::CloseHandle(m_mapping);
+                    m_mapping = nullptr;
+                }
+            }
+        }
+        ::CloseHandle(file);
+    }
+#endif
+
+    if (m_mapped)
+        return;
+
+    // Fall back to reading the file (this also handles empty files, which can't be mapped):
+    wxFile f;
+    if (!f.Open(filename, wxFile::read))
+        return;
+    auto length = f.Length();
+    if (length < 0)
+        return;
+    m_buffer.resize((size_t)length);
+    if (length > 0 && f.Read(m_buffer.data(), m_buffer.size()) != (ssize_t)m_buffer.size())
+        return;
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    m_ok = true;
+}
+
+MappedFile::~MappedFile()
+{
+    Unmap();
+}
+
+void MappedFile::Unmap()
+{
+    if (!m_mapped)
+        return;
+#if defined(__UNIX__)
+    munmap(const_cast<char*>(m_data), m_size);
+#elif defined(__WXMSW__)
+    ::UnmapViewOfFile(m_data);
+    ::CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#endif
+    m_mapped = false;
+    m_data = nullptr;
+    m_size = 0;
+}
+
+
 #ifdef __WXMSW__
 wxString CliSafeFileName(const wxString& fn)
 {
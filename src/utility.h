@@ -27,6 +27,8 @@
 #define Poedit_utility_h
 
 #include <map>
+#include <string>
+#include <string_view>
 
 #include <wx/arrstr.h>
 #include <wx/filename.h>
@@ -290,6 +292,42 @@ public:
 };
 
 
+/**
+    Read-only view of a file's entire content.
+
+    The file is memory-mapped if possible, otherwise (e.g. on filesystems that
+    don't support mapping) read into memory. Use IsOk() to check for errors.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const wxString& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsOk() const { return m_ok; }
+
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    std::string_view view() const { return std::string_view(m_data, m_size); }
+
+private:
+    void Unmap();
+
+    bool m_ok = false;
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    std::string m_buffer;  // used if mapping isn't possible
+#ifdef __WXMSW__
+    void *m_mapping = nullptr;
+#endif
+    bool m_mapped = false;
+};
+
+
 #ifdef __WXMSW__
 /// Return filename safe for passing to CLI tools (gettext).
 /// Uses 8.3 short names to avoid Unicode and codepage issues.
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Checks that merging duplicate entries (poedit --batch --fix-duplicates)
+# keeps all translator comments in a single, unbroken entry.
+#
+
+set -e
+
+: "${srcdir:=.}"
+: "${POEDIT:=src/poedit}"
+
+if [ -z "$DISPLAY" ] && command -v xvfb-run >/dev/null 2>&1 ; then
+    POEDIT="xvfb-run -a $POEDIT"
+fi
+
+TMPDIR=`mktemp -d`
+trap 'rm -rf "$TMPDIR"' EXIT
+
+cp "$srcdir/tests/po/duplicates.po" "$TMPDIR/duplicates.po"
+$POEDIT --batch --fix-duplicates "$TMPDIR/duplicates.po" >/dev/null
+
+# print the entry (i.e. paragraph) with msgid "Hello":
+awk -v RS= '/(^|\n)msgid "Hello"\n/' "$TMPDIR/duplicates.po" >"$TMPDIR/actual"
+
+cat >"$TMPDIR/expected" <<END
+# first translator comment
+# second translator comment
+msgid "Hello"
+msgstr "Ahoj"
+END
+
+if ! cmp -s "$TMPDIR/expected" "$TMPDIR/actual" ; then
+    echo "merged entry differs from expected:" >&2
+    diff -u "$TMPDIR/expected" "$TMPDIR/actual" >&2 || true
+    exit 1
+fi
+
+if [ `grep -c '^msgid "Hello"$' "$TMPDIR/duplicates.po"` -ne 1 ] ; then
+    echo "duplicate entries were not merged" >&2
+    exit 1
+fi
@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+# Checks that PO files saved by Poedit are formatted (i.e. wrapped) the same
+# way GNU gettext's msgcat formats them: long, CJK, escape-heavy and format
+# strings' lines must be identical to msgcat's rendering of the same file.
+#
+
+set -e
+
+: "${srcdir:=.}"
+: "${POEDIT:=src/poedit}"
+
+if ! command -v msgcat >/dev/null 2>&1 ; then
+    echo "gettext tools not available, skipping" >&2
+    exit 77
+fi
+
+if [ -z "$DISPLAY" ] && command -v xvfb-run >/dev/null 2>&1 ; then
+    POEDIT="xvfb-run -a $POEDIT"
+fi
+
+TMPDIR=`mktemp -d`
+trap 'rm -rf "$TMPDIR"' EXIT
+
+# The fixture has a duplicate entry, so that merging it makes Poedit rewrite
+# the whole file instead of only the changed entries:
+cp "$srcdir/tests/po/wrapping.po" "$TMPDIR/poedit.po"
+$POEDIT --batch --fix-duplicates "$TMPDIR/poedit.po" >/dev/null
+
+msgcat -o "$TMPDIR/msgcat.po" "$TMPDIR/poedit.po"
+
+if ! diff -u "$TMPDIR/msgcat.po" "$TMPDIR/poedit.po" >&2 ; then
+    echo "PO file saved by Poedit is formatted differently from msgcat output" >&2
+    exit 1
+fi